@@ -1,4 +1,5 @@
 option(ENABLE_SANITIZER "Enable ASan+LSan+UBSan sanitizer (Debug build only)" OFF)
+option(ENABLE_IO_URING "Use io_uring for batch loading of configuration files (Linux only)" ON)
 
 set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
 
@@ -0,0 +1,16 @@
+# bench_uci2
+add_executable(
+    bench_uci2
+    benchmarks/bench_uci2.c
+)
+
+target_link_libraries(
+    bench_uci2
+    uci2
+)
+
+set_target_properties(
+    bench_uci2
+    PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/benchmarks
+)
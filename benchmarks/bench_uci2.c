@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+// mkdtemp()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <linux/limits.h>
+#include <unistd.h>
+
+#include "uci2.h"
+
+#define BENCH_FILES_NUMBER_DEFAULT (10000)
+#define BENCH_ROUNDS (5)
+
+// small per-device configuration, every file gets its own hostname
+static const char bench_config_format[] =
+	"config system\n"
+	"\toption hostname 'device-%zu'\n"
+	"\toption timezone 'UTC'\n"
+	"\toption log_size '64'\n"
+	"\n"
+	"config timeserver 'ntp'\n"
+	"\toption enabled '1'\n"
+	"\tlist server '0.openwrt.pool.ntp.org'\n"
+	"\tlist server '1.openwrt.pool.ntp.org'\n"
+	"\n"
+	"config interface 'lan'\n"
+	"\toption proto 'static'\n"
+	"\toption ipaddr '192.168.%zu.1'\n"
+	"\toption netmask '255.255.255.0'\n";
+
+static double bench_time_get(void);
+static int bench_files_create(const char *directory, size_t files_number, char **configs);
+static void bench_files_remove(size_t files_number, char **configs);
+static double bench_per_file(size_t files_number, char **configs, uci2_ast_t **asts);
+static double bench_batch(size_t files_number, char **configs, uci2_ast_t **asts, uci2_error_e *errors);
+
+int main(int argc, char **argv)
+{
+	int error = EXIT_SUCCESS;
+	size_t files_number = BENCH_FILES_NUMBER_DEFAULT;
+	char directory[] = "/tmp/uci2_bench_XXXXXX";
+	char **configs = NULL;
+	uci2_ast_t **asts = NULL;
+	uci2_error_e *errors = NULL;
+	double per_file_time = 0;
+	double batch_time = 0;
+	double time = 0;
+
+	if (argc > 1) {
+		files_number = strtoul(argv[1], NULL, 10);
+	}
+
+	if (files_number == 0) {
+		fprintf(stderr, "usage: %s [files_number]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (mkdtemp(directory) == NULL) {
+		perror("mkdtemp");
+		return EXIT_FAILURE;
+	}
+
+	configs = calloc(files_number, sizeof(char *));
+	asts = calloc(files_number, sizeof(uci2_ast_t *));
+	errors = calloc(files_number, sizeof(uci2_error_e));
+	if (configs == NULL || asts == NULL || errors == NULL) {
+		error = EXIT_FAILURE;
+		goto out;
+	}
+
+	if (bench_files_create(directory, files_number, configs)) {
+		error = EXIT_FAILURE;
+		goto out;
+	}
+
+	// warm up the page cache so both paths read from memory
+	bench_per_file(files_number, configs, asts);
+
+	for (size_t i = 0; i < BENCH_ROUNDS; i++) {
+		time = bench_per_file(files_number, configs, asts);
+		if (time < 0) {
+			error = EXIT_FAILURE;
+			goto out;
+		}
+		per_file_time = (i == 0 || time < per_file_time) ? time : per_file_time;
+
+		time = bench_batch(files_number, configs, asts, errors);
+		if (time < 0) {
+			error = EXIT_FAILURE;
+			goto out;
+		}
+		batch_time = (i == 0 || time < batch_time) ? time : batch_time;
+	}
+
+	printf("files:                   %zu\n", files_number);
+	printf("uci2_config_parse:       %.3f ms (%.0f files/s)\n", per_file_time * 1e3, (double) files_number / per_file_time);
+	printf("uci2_config_parse_batch: %.3f ms (%.0f files/s)\n", batch_time * 1e3, (double) files_number / batch_time);
+	printf("speedup:                 %.2fx\n", per_file_time / batch_time);
+
+out:
+	if (configs) {
+		bench_files_remove(files_number, configs);
+	}
+	rmdir(directory);
+	free(configs);
+	free(asts);
+	free(errors);
+
+	return error;
+}
+
+static double bench_time_get(void)
+{
+	struct timespec now = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+static int bench_files_create(const char *directory, size_t files_number, char **configs)
+{
+	char path[PATH_MAX] = {0};
+	FILE *file = NULL;
+
+	for (size_t i = 0; i < files_number; i++) {
+		snprintf(path, sizeof(path), "%s/device_%zu", directory, i);
+
+		file = fopen(path, "w");
+		if (file == NULL) {
+			perror("fopen");
+			return -1;
+		}
+
+		fprintf(file, bench_config_format, i, i % 256);
+		fclose(file);
+
+		configs[i] = strdup(path);
+		if (configs[i] == NULL) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void bench_files_remove(size_t files_number, char **configs)
+{
+	for (size_t i = 0; i < files_number && configs[i]; i++) {
+		unlink(configs[i]);
+		free(configs[i]);
+	}
+}
+
+static double bench_per_file(size_t files_number, char **configs, uci2_ast_t **asts)
+{
+	double start = bench_time_get();
+	double time = 0;
+
+	for (size_t i = 0; i < files_number; i++) {
+		if (uci2_config_parse(configs[i], &asts[i])) {
+			fprintf(stderr, "uci2_config_parse(%s) failed\n", configs[i]);
+			return -1;
+		}
+	}
+
+	time = bench_time_get() - start;
+
+	for (size_t i = 0; i < files_number; i++) {
+		uci2_ast_destroy(&asts[i]);
+	}
+
+	return time;
+}
+
+static double bench_batch(size_t files_number, char **configs, uci2_ast_t **asts, uci2_error_e *errors)
+{
+	double start = bench_time_get();
+	double time = 0;
+
+	if (uci2_config_parse_batch((const char **) configs, files_number, asts, errors)) {
+		fprintf(stderr, "uci2_config_parse_batch failed\n");
+		return -1;
+	}
+
+	time = bench_time_get() - start;
+
+	for (size_t i = 0; i < files_number; i++) {
+		if (errors[i]) {
+			fprintf(stderr, "uci2_config_parse_batch(%s) failed\n", configs[i]);
+			time = -1;
+		}
+		uci2_ast_destroy(&asts[i]);
+	}
+
+	return time;
+}
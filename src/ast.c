@@ -9,8 +9,28 @@
 #include <assert.h>
 
 #include "utils/memory.h"
+#include "utils/hash.h"
 
 #include "ast.h"
+#include "index.h"
+#include "txn.h"
+#include "journal.h"
+
+typedef struct ast_copy_s ast_copy_t;
+
+// next free places in the blocks of ast_tree_copy()
+struct ast_copy_s {
+	ast_node_t *nodes;
+	ast_node_t **children;
+	char *strings;
+};
+
+static size_t ast_node_unlink(ast_node_t *node);
+static void ast_node_link(ast_node_t *parent, ast_node_t *node, size_t index, size_t position);
+static void ast_node_children_detach(ast_node_t *node);
+static ast_node_t *ast_tree_copy(ast_t *ast, const ast_node_t *source);
+static void ast_node_copy_size(const ast_node_t *node, size_t *nodes_number, size_t *children_number, size_t *strings_size);
+static ast_node_t *ast_node_copy(ast_t *ast, ast_node_t *parent, const ast_node_t *source, ast_copy_t *copy);
 
 void ast_init(ast_t *ast)
 {
@@ -18,9 +38,20 @@ void ast_init(ast_t *ast)
 
 	ast->root = NULL;
 	ast->pool = xcalloc(1, sizeof(ast_node_t));
+	ast->config = NULL;
+	ast->index = NULL;
+	ast->txn = NULL;
+	ast->journal = NULL;
+	ast->blocks = NULL;
+	ast->blocks_number = 0;
 }
 
 ast_node_t *ast_node_new(ast_t *ast, enum ast_node_type type, char *name, char *value)
+{
+	return ast_node_new_hashed(ast, type, name, hash_string(name), value, hash_string(value));
+}
+
+ast_node_t *ast_node_new_hashed(ast_t *ast, enum ast_node_type type, char *name, uint64_t name_hash, char *value, uint64_t value_hash)
 {
 	ast_node_t *node = NULL;
 
@@ -30,6 +61,9 @@ ast_node_t *ast_node_new(ast_t *ast, enum ast_node_type type, char *name, char *
 	node->type = type;
 	node->name = name;
 	node->value = value;
+	node->name_hash = name_hash;
+	node->value_hash = value_hash;
+	node->ast = ast;
 
 	ast_node_add(ast->pool, node);
 
@@ -41,31 +75,251 @@ void ast_node_add(ast_node_t *parent, ast_node_t *node)
 	assert(parent);
 	assert(node);
 
+	ast_node_children_detach(parent);
 	node->parent = parent;
 	parent->children_number++;
 	parent->children = xrealloc(parent->children, parent->children_number * sizeof(ast_node_t *));
 	parent->children[parent->children_number - 1] = node;
+
+	if (node->name && (node->type == ANT_OPTION || node->type == ANT_LIST || node->type == ANT_LIST_ITEM)) {
+		parent->children_filter |= AST_NODE_FILTER_BITS(node->name_hash);
+	}
+
+	if (parent->children_sequence) {
+		sequence_append(parent->children_sequence, &node->sibling_link);
+	}
+
+	// nodes entering the pool are not part of the tree yet
+	if (node->ast->txn && parent != node->ast->pool) {
+		txn_record(node->ast, TET_ADD, node, NULL, 0, 0, NULL);
+	}
+}
+
+void ast_node_remove(ast_node_t *node)
+{
+	assert(node);
+
+	// indexes are updated while the node is still attached
+	if (node->parent) {
+		if (node->ast->txn) {
+			ast_node_children_sequence_get(node->parent);
+			txn_record(node->ast, TET_REMOVE, node, node->parent, 0, sequence_position_get(&node->sibling_link), NULL);
+		}
+
+		index_node_remove(node);
+
+		if (node->parent->children_sequence) {
+			sequence_remove(node->parent->children_sequence, &node->sibling_link);
+		}
+	}
+
+	node->parent = NULL;
 }
 
 void ast_destroy(ast_t *ast)
 {
+	ast_node_t *node = NULL;
+
 	if (ast) {
+		index_destroy(ast);
+		txn_destroy(ast);
+		journal_destroy(ast);
+
 		if (ast->pool) {
 			for (size_t i = 0; i < ast->pool->children_number; i++) {
-				XFREE(ast->pool->children[i]->name);
-				XFREE(ast->pool->children[i]->value);
-				XFREE(ast->pool->children[i]->children);
-				XFREE(ast->pool->children[i]);
+				node = ast->pool->children[i];
+				// parts held in the blocks go with the blocks
+				if ((node->storage & ANS_NAME) == 0) {
+					XFREE(node->name);
+				}
+				if ((node->storage & ANS_VALUE) == 0) {
+					XFREE(node->value);
+				}
+				if ((node->storage & ANS_CHILDREN) == 0) {
+					XFREE(node->children);
+				}
+				hash_table_destroy(node->children_index);
+				XFREE(node->children_index);
+				XFREE(node->children_sequence);
+				if ((node->storage & ANS_NODE) == 0) {
+					XFREE(node);
+				}
 			}
 
 			XFREE(ast->pool->children);
 			XFREE(ast->pool);
 		}
 
+		for (size_t i = 0; i < ast->blocks_number; i++) {
+			XFREE(ast->blocks[i]);
+		}
+		XFREE(ast->blocks);
+
 		XFREE(ast);
 	}
 }
 
+ast_t *ast_clone(ast_t *ast)
+{
+	ast_t *clone = NULL;
+
+	assert(ast);
+
+	clone = xcalloc(1, sizeof(ast_t));
+	ast_init(clone);
+
+	if (ast->root) {
+		clone->root = ast_tree_copy(clone, ast->root);
+	}
+
+	return clone;
+}
+
+ast_node_t *ast_config_get(ast_t *ast)
+{
+	assert(ast);
+
+	if (ast->config == NULL && ast->root) {
+		for (size_t i = 0; i < ast->root->children_number; i++) {
+			if (ast->root->children[i] &&
+				ast->root->children[i]->type == ANT_CONFIG) {
+				ast->config = ast->root->children[i];
+				break;
+			}
+		}
+	}
+
+	// the config node is never replaced, only removed
+	if (ast->config && ast->config->parent == NULL) {
+		return NULL;
+	}
+
+	return ast->config;
+}
+
+sequence_t *ast_node_children_sequence_get(ast_node_t *node)
+{
+	assert(node);
+
+	if (node->children_sequence) {
+		return node->children_sequence;
+	}
+
+	node->children_sequence = xcalloc(1, sizeof(sequence_t));
+	sequence_init(node->children_sequence);
+
+	for (size_t i = 0; i < node->children_number; i++) {
+		if (node->children[i]->parent) {
+			sequence_append(node->children_sequence, &node->children[i]->sibling_link);
+		}
+	}
+
+	return node->children_sequence;
+}
+
+void ast_node_children_order(ast_node_t *node)
+{
+	ast_node_t **children = NULL;
+	sequence_link_t *link = NULL;
+	size_t children_number = 0;
+
+	assert(node);
+
+	if (node->children_stale == false) {
+		return;
+	}
+
+	// live children in the order of the sequence, the removed ones after them in their old order
+	children = xmalloc(node->children_number * sizeof(ast_node_t *));
+	for (link = sequence_first(node->children_sequence); link; link = sequence_next(link)) {
+		children[children_number++] = AST_NODE_FROM_LINK(link);
+	}
+
+	for (size_t i = 0; i < node->children_number; i++) {
+		if (node->children[i]->parent == NULL) {
+			children[children_number++] = node->children[i];
+		}
+	}
+
+	assert(children_number == node->children_number);
+
+	ast_node_children_detach(node);
+	XFREE(node->children);
+	node->children = children;
+	node->children_stale = false;
+}
+
+void ast_node_name_set(ast_node_t *node, const char *name)
+{
+	char *name_copy = name ? xstrdup(name) : NULL;
+
+	assert(node);
+
+	// a name held in a block is not freed on its own, it is swapped for a copy first
+	if (node->storage & ANS_NAME) {
+		node->name = xstrdup(node->name);
+		node->storage &= ~ANS_NAME;
+	}
+
+	if (node->parent) {
+		index_node_unname(node);
+	}
+
+	// the old name is kept by the undo log
+	if (node->ast->txn) {
+		txn_record(node->ast, TET_NAME, node, NULL, 0, 0, node->name);
+		node->name = NULL;
+	}
+
+	XFREE(node->name);
+	node->name = name_copy;
+	node->name_hash = hash_string(name_copy);
+
+	if (node->parent) {
+		index_node_name(node);
+	}
+}
+
+void ast_node_value_set(ast_node_t *node, const char *value)
+{
+	char *value_copy = value ? xstrdup(value) : NULL;
+
+	assert(node);
+
+	if (node->storage & ANS_VALUE) {
+		node->value = xstrdup(node->value);
+		node->storage &= ~ANS_VALUE;
+	}
+
+	if (node->parent) {
+		index_node_unvalue(node);
+	}
+
+	if (node->ast->txn) {
+		txn_record(node->ast, TET_VALUE, node, NULL, 0, 0, node->value);
+		node->value = NULL;
+	}
+
+	XFREE(node->value);
+	node->value = value_copy;
+	node->value_hash = hash_string(value_copy);
+
+	if (node->parent) {
+		index_node_value(node);
+	}
+}
+
+bool ast_node_name_equal(const ast_node_t *node, const char *name, uint64_t name_hash)
+{
+	assert(node);
+	assert(name);
+
+	// compare the precomputed hashes first, strings only on a hash match
+	return node->name &&
+		   node->name_hash == name_hash &&
+		   strcmp(node->name, name) == 0;
+}
+
 void ast_node_move(ast_node_t *destination, ast_node_t *source)
 {
 	assert(destination);
@@ -73,73 +327,346 @@ void ast_node_move(ast_node_t *destination, ast_node_t *source)
 	assert(source);
 	assert(source->parent);
 
+	XFREE(destination->children_sequence);
+
 	destination->children = source->children;
 	destination->children_number = source->children_number;
-	destination->unnamed_children_number = source->unnamed_children_number;
+	destination->children_sequence = source->children_sequence;
+	destination->children_filter = source->children_filter;
+	destination->children_filter_stale = source->children_filter_stale;
+	destination->children_stale = source->children_stale;
+	destination->storage = (destination->storage & ~ANS_CHILDREN) | (source->storage & ANS_CHILDREN);
+	source->storage &= ~ANS_CHILDREN;
 	source->children = NULL;
 	source->children_number = 0;
-	source->unnamed_children_number = 0;
+	source->children_sequence = NULL;
+	source->children_filter = 0;
+	source->children_filter_stale = 0;
+	source->children_stale = false;
 	for (size_t i = 0; i < destination->children_number; i++) {
 		destination->children[i]->parent = destination;
 	}
 }
 
-void ast_node_merge(ast_node_t *node, enum ast_node_type type)
+void ast_node_merge(ast_node_t *node)
 {
+	hash_table_t first = {0};
+	ast_node_t *child = NULL;
+	ast_node_t *found = NULL;
+	size_t position = 0;
+
 	assert(node);
 	assert(node->parent);
 
+	// the first child with a name collects the children of all later ones, found by name hash
+	hash_table_init(&first);
+
 	for (size_t i = 0; i < node->children_number; i++) {
-		if (node->children[i] == NULL &&
-			node->children[i]->parent == NULL &&
-			node->children[i]->type != type &&
-			node->children[i]->name == NULL) {
+		child = node->children[i];
+
+		// nodes merged away earlier have no children left and take no further part
+		if (child->parent == NULL || child->name == NULL) {
 			continue;
 		}
 
-		for (size_t j = i + 1; j < node->children_number; j++) {
-			if (node->children[j]->name &&
-				node->children[i]->name &&
-				strcmp(node->children[j]->name, node->children[i]->name) == 0) {
-				for (size_t k = 0; k < node->children[j]->children_number; k++) {
-					ast_node_add(node->children[i], node->children[j]->children[k]);
-				}
+		position = HASH_TABLE_POSITION_START;
+		while ((found = hash_table_find(&first, child->name_hash, &position))) {
+			if (ast_node_name_equal(found, child->name, child->name_hash)) {
+				break;
+			}
+		}
 
-				node->children[j]->children_number = 0;
-				node->children[j]->unnamed_children_number = 0;
-				node->children[j]->parent = NULL;
+		if (found == NULL) {
+			hash_table_insert(&first, child->name_hash, child);
+			continue;
+		}
+
+		// the moved children are relinked into the sequence of the node they join, removed ones stay removed
+		ast_node_children_order(child);
+		XFREE(child->children_sequence);
+
+		for (size_t k = 0; k < child->children_number; k++) {
+			if (child->children[k]->parent) {
+				ast_node_add(found, child->children[k]);
 			}
 		}
+
+		child->children_number = 0;
+		ast_node_remove(child);
+	}
+
+	hash_table_destroy(&first);
+}
+
+void ast_node_reparent(ast_node_t *parent, ast_node_t *node)
+{
+	ast_node_t *old_parent = NULL;
+	size_t position = 0;
+	size_t index = 0;
+
+	assert(parent);
+	assert(node);
+	assert(node->parent);
+
+	old_parent = node->parent;
+	if (node->ast->txn) {
+		ast_node_children_sequence_get(old_parent);
+		position = sequence_position_get(&node->sibling_link);
+	}
+
+	index = ast_node_unlink(node);
+
+	if (node->ast->txn) {
+		txn_record(node->ast, TET_REPARENT, node, old_parent, index, position, NULL);
+	}
+
+	ast_node_children_detach(parent);
+	node->parent = parent;
+	parent->children_number++;
+	parent->children = xrealloc(parent->children, parent->children_number * sizeof(ast_node_t *));
+	parent->children[parent->children_number - 1] = node;
+
+	if (parent->children_sequence) {
+		sequence_append(parent->children_sequence, &node->sibling_link);
+	}
+}
+
+void ast_node_reparent_at(ast_node_t *parent, ast_node_t *node, size_t index, size_t position)
+{
+	assert(parent);
+	assert(node);
+	assert(node->parent);
+	assert(index <= parent->children_number);
+
+	ast_node_unlink(node);
+	ast_node_link(parent, node, index, position);
+}
+
+void ast_node_position_set(ast_node_t *node, size_t position)
+{
+	ast_node_t *parent = NULL;
+	sequence_t *sequence = NULL;
+	size_t old_position = 0;
+
+	assert(node);
+	assert(node->parent);
+
+	parent = node->parent;
+	sequence = ast_node_children_sequence_get(parent);
+	assert(position < sequence_size_get(sequence));
+
+	old_position = sequence_position_get(&node->sibling_link);
+	if (old_position == position) {
+		return;
+	}
+
+	if (node->ast->txn) {
+		txn_record(node->ast, TET_POSITION, node, parent, 0, old_position, NULL);
+	}
+
+	// only the sequence is changed, the children follow it the next time they are walked in order
+	sequence_remove(sequence, &node->sibling_link);
+	sequence_insert(sequence, &node->sibling_link, position);
+	parent->children_stale = true;
+}
+
+void ast_node_restore(ast_node_t *parent, ast_node_t *node, size_t position)
+{
+	assert(parent);
+	assert(node);
+	assert(node->parent == NULL);
+
+	// a removed node never left the children of its parent, it only comes back to life
+	node->parent = parent;
+
+	// the removed node is not necessarily at that position in the children
+	if (parent->children_sequence) {
+		sequence_insert(parent->children_sequence, &node->sibling_link, position);
+		parent->children_stale = true;
 	}
+
+	index_node_restore(node);
 }
 
-void unnamed_section_name_set(ast_node_t *config_node)
+size_t unnamed_section_name_get(ast_node_t *section_node, char *buffer, size_t buffer_size)
 {
 	ast_node_t *section_type_node = NULL;
-	ast_node_t *section_name_node = NULL;
-	char unnamed_section_name[UNNAMED_SECTION_NAME_BUFFER_SIZE_MAX + 1] = {0};
-
-	assert(config_node);
-	assert(config_node->parent);
-
-	for (size_t i = 0; i < config_node->children_number; i++) {
-		section_type_node = config_node->children[i];
-		if (section_type_node &&
-			section_type_node->parent &&
-			section_type_node->name) {
-			for (size_t j = 0; j < config_node->children[i]->children_number; j++) {
-				section_name_node = section_type_node->children[j];
-				if (section_name_node &&
-					section_name_node->parent &&
-					section_name_node->type == ANT_SECTION_NAME &&
-					section_name_node->name &&
-					strcmp(section_name_node->name, UNNAMED_SECTION_NAME_PLACEHOLDER) == 0) {
-					XFREE(section_name_node->name);
-					snprintf(unnamed_section_name, sizeof(unnamed_section_name), "@%s[%zu]", section_type_node->name, section_type_node->unnamed_children_number);
-					section_name_node->name = xstrdup(unnamed_section_name);
-					section_type_node->unnamed_children_number++;
-				}
+	size_t position = 0;
+
+	assert(section_node);
+	assert(section_node->parent);
+
+	// the position counts the live sections of the type, so later sections move up when one is removed,
+	// the order is only read here, a type whose order is not built yet is counted in the children array
+	section_type_node = section_node->parent;
+	if (section_type_node->children_sequence) {
+		position = sequence_position_get(&section_node->sibling_link);
+	} else {
+		for (size_t i = 0; section_type_node->children[i] != section_node; i++) {
+			if (section_type_node->children[i]->parent) {
+				position++;
 			}
 		}
 	}
+
+	// the length of the whole name is returned as by snprintf() so the caller can size the buffer
+	return (size_t) snprintf(buffer, buffer_size, "@%s[%zu]", section_type_node->name, position);
+}
+
+static size_t ast_node_unlink(ast_node_t *node)
+{
+	ast_node_t *parent = node->parent;
+	size_t index = 0;
+
+	// the node leaves the children of its parent entirely, left behind it would count as a live child there
+	if (parent->children_sequence) {
+		sequence_remove(parent->children_sequence, &node->sibling_link);
+	}
+
+	for (index = 0; index < parent->children_number; index++) {
+		if (parent->children[index] == node) {
+			memmove(&parent->children[index], &parent->children[index + 1], (parent->children_number - index - 1) * sizeof(ast_node_t *));
+			parent->children_number--;
+			break;
+		}
+	}
+
+	return index;
+}
+
+static void ast_node_link(ast_node_t *parent, ast_node_t *node, size_t index, size_t position)
+{
+	ast_node_children_detach(parent);
+	node->parent = parent;
+	parent->children_number++;
+	parent->children = xrealloc(parent->children, parent->children_number * sizeof(ast_node_t *));
+	memmove(&parent->children[index + 1], &parent->children[index], (parent->children_number - index - 1) * sizeof(ast_node_t *));
+	parent->children[index] = node;
+
+	if (parent->children_sequence) {
+		sequence_insert(parent->children_sequence, &node->sibling_link, position);
+		parent->children_stale = true;
+	}
+}
+
+static void ast_node_children_detach(ast_node_t *node)
+{
+	ast_node_t **children = NULL;
+
+	// children held in a block can not be grown or freed, they get an allocation of their own first
+	if (node->storage & ANS_CHILDREN) {
+		if (node->children_number) {
+			children = xmalloc(node->children_number * sizeof(ast_node_t *));
+			memcpy(children, node->children, node->children_number * sizeof(ast_node_t *));
+		}
+
+		node->children = children;
+		node->storage &= ~ANS_CHILDREN;
+	}
+}
+
+static ast_node_t *ast_tree_copy(ast_t *ast, const ast_node_t *source)
+{
+	ast_node_t *pool = ast->pool;
+	ast_copy_t copy = {0};
+	size_t nodes_number = 0;
+	size_t children_number = 0;
+	size_t strings_size = 0;
+
+	// the live nodes, their children arrays and their strings each go into one block
+	ast_node_copy_size(source, &nodes_number, &children_number, &strings_size);
+
+	ast->blocks = xrealloc(ast->blocks, (ast->blocks_number + 3) * sizeof(void *));
+	copy.nodes = xcalloc(nodes_number, sizeof(ast_node_t));
+	ast->blocks[ast->blocks_number++] = copy.nodes;
+	if (children_number) {
+		copy.children = xmalloc(children_number * sizeof(ast_node_t *));
+		ast->blocks[ast->blocks_number++] = copy.children;
+	}
+	if (strings_size) {
+		copy.strings = xmalloc(strings_size);
+		ast->blocks[ast->blocks_number++] = copy.strings;
+	}
+
+	// the pool takes all the copies at once instead of growing by one node at a time
+	pool->children = xrealloc(pool->children, (pool->children_number + nodes_number) * sizeof(ast_node_t *));
+
+	return ast_node_copy(ast, pool, source, &copy);
+}
+
+static void ast_node_copy_size(const ast_node_t *node, size_t *nodes_number, size_t *children_number, size_t *strings_size)
+{
+	(*nodes_number)++;
+	*strings_size += node->name ? strlen(node->name) + 1 : 0;
+	*strings_size += node->value ? strlen(node->value) + 1 : 0;
+
+	for (size_t i = 0; i < node->children_number; i++) {
+		if (node->children[i]->parent) {
+			(*children_number)++;
+			ast_node_copy_size(node->children[i], nodes_number, children_number, strings_size);
+		}
+	}
+}
+
+static ast_node_t *ast_node_copy(ast_t *ast, ast_node_t *parent, const ast_node_t *source, ast_copy_t *copy)
+{
+	ast_node_t *node = NULL;
+	sequence_link_t *link = NULL;
+	size_t children_number = 0;
+	size_t string_size = 0;
+
+	// the block is zeroed, the hashes are copied along and the strings go into the string block
+	node = copy->nodes++;
+	node->storage = ANS_NODE;
+	node->type = source->type;
+	if (source->name) {
+		string_size = strlen(source->name) + 1;
+		node->name = memcpy(copy->strings, source->name, string_size);
+		node->storage |= ANS_NAME;
+		copy->strings += string_size;
+	}
+	if (source->value) {
+		string_size = strlen(source->value) + 1;
+		node->value = memcpy(copy->strings, source->value, string_size);
+		node->storage |= ANS_VALUE;
+		copy->strings += string_size;
+	}
+	node->name_hash = source->name_hash;
+	node->value_hash = source->value_hash;
+	node->ast = ast;
+	node->parent = parent;
+	// the filter of the source covers all of its live children
+	node->children_filter = source->children_filter;
+	node->children_filter_stale = source->children_filter_stale;
+
+	// space for the copy was reserved by ast_tree_copy()
+	ast->pool->children[ast->pool->children_number++] = node;
+
+	// removed nodes are left behind
+	for (size_t i = 0; i < source->children_number; i++) {
+		if (source->children[i]->parent) {
+			children_number++;
+		}
+	}
+
+	if (children_number) {
+		node->children = copy->children;
+		node->storage |= ANS_CHILDREN;
+		copy->children += children_number;
+	}
+
+	// moved children are copied in the order of the sequence, the source is left as it is
+	if (source->children_stale) {
+		for (link = sequence_first(source->children_sequence); link; link = sequence_next(link)) {
+			node->children[node->children_number++] = ast_node_copy(ast, node, AST_NODE_FROM_LINK(link), copy);
+		}
+	} else {
+		for (size_t i = 0; i < source->children_number; i++) {
+			if (source->children[i]->parent) {
+				node->children[node->children_number++] = ast_node_copy(ast, node, source->children[i], copy);
+			}
+		}
+	}
+
+	return node;
 }
@@ -6,21 +6,43 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include "utils/hash_table.h"
+#include "utils/sequence.h"
 
 #define AST_NODE_ROOT_NAME "/"
 #define AST_NODE_CONFIG_NAME "@C"
 #define AST_NODE_PACKAGE_NAME "@P"
 
-#define UNNAMED_SECTION_NAME_PLACEHOLDER "@<type>[<N>]"
-#define UNNAMED_SECTION_NAME_BUFFER_SIZE_MAX (1024)
+// two bits of the name hash in the Bloom filter of the parent
+#define AST_NODE_FILTER_BITS(hash) ((UINT64_C(1) << ((hash) & 63)) | (UINT64_C(1) << ((hash) >> 58)))
+
+// parts of a node copied into the blocks of ast_tree_copy()
+#define ANS_NODE (1U << 0)
+#define ANS_NAME (1U << 1)
+#define ANS_VALUE (1U << 2)
+#define ANS_CHILDREN (1U << 3)
+
+#define AST_NODE_FROM_LINK(link) ((ast_node_t *) (void *) ((char *) (link) - offsetof(ast_node_t, sibling_link)))
 
 typedef struct ast_s ast_t;
 typedef struct ast_node_s ast_node_t;
+typedef struct index_s index_t;
+typedef struct txn_s txn_t;
+typedef struct journal_s journal_t;
 
 struct ast_s {
 	ast_node_t *root;
 	ast_node_t *pool;
+	ast_node_t *config; // cached ANT_CONFIG node, looked up on first use
+	index_t *index;     // lookup indexes, built on first use
+	txn_t *txn;         // undo log of the open transaction, NULL outside of one
+	journal_t *journal; // change journal of the package, NULL unless one is open
+	void **blocks;      // node, children and string blocks filled by ast_tree_copy()
+	size_t blocks_number;
 };
 
 struct ast_node_s {
@@ -37,19 +59,42 @@ struct ast_node_s {
 	} type;
 	char *name;
 	char *value;
+	uint64_t name_hash;  // hash_string() of name, 0 if name is NULL
+	uint64_t value_hash; // hash_string() of value, 0 if value is NULL
+	ast_t *ast;
 	ast_node_t *parent;
 	ast_node_t **children;
 	size_t children_number;
-	size_t unnamed_children_number;
+	hash_table_t *children_index; // child name hash -> child node, see index_child_find()
+	uint64_t children_filter;     // Bloom filter over the names of option, list and list element children
+	size_t children_filter_stale; // children removed or renamed since the filter was built
+	sequence_t *children_sequence; // live children in order, see ast_node_children_sequence_get()
+	sequence_link_t sibling_link;  // link in the children_sequence of the parent
+	bool children_stale;           // children not in the order of children_sequence, see ast_node_children_order()
+	unsigned int storage;          // ANS_* parts held in the blocks of the AST instead of allocations of their own
 };
 
 void ast_init(ast_t *ast);
 ast_node_t *ast_node_new(ast_t *ast, enum ast_node_type type, char *name, char *value);
+ast_node_t *ast_node_new_hashed(ast_t *ast, enum ast_node_type type, char *name, uint64_t name_hash, char *value, uint64_t value_hash);
 void ast_node_add(ast_node_t *parent, ast_node_t *node);
+void ast_node_remove(ast_node_t *node);
 void ast_destroy(ast_t *ast);
+ast_t *ast_clone(ast_t *ast);
+ast_node_t *ast_config_get(ast_t *ast);
+sequence_t *ast_node_children_sequence_get(ast_node_t *node);
+void ast_node_children_order(ast_node_t *node);
+
+void ast_node_name_set(ast_node_t *node, const char *name);
+void ast_node_value_set(ast_node_t *node, const char *value);
+bool ast_node_name_equal(const ast_node_t *node, const char *name, uint64_t name_hash);
 
 void ast_node_move(ast_node_t *destination, ast_node_t *source);
-void ast_node_merge(ast_node_t *node, enum ast_node_type type);
-void unnamed_section_name_set(ast_node_t *config_node);
+void ast_node_merge(ast_node_t *node);
+void ast_node_reparent(ast_node_t *parent, ast_node_t *node);
+void ast_node_reparent_at(ast_node_t *parent, ast_node_t *node, size_t index, size_t position);
+void ast_node_restore(ast_node_t *parent, ast_node_t *node, size_t position);
+void ast_node_position_set(ast_node_t *node, size_t position);
+size_t unnamed_section_name_get(ast_node_t *section_node, char *buffer, size_t buffer_size);
 
 #endif /* ifndef AST_H */
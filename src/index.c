@@ -0,0 +1,1277 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "utils/memory.h"
+#include "utils/hash.h"
+
+#include "index.h"
+
+typedef struct {
+	const char *substring;
+	ast_node_t **nodes;
+	size_t nodes_number;
+	size_t nodes_size;
+} index_search_t;
+
+static index_t *index_get(ast_t *ast);
+static ast_node_t *index_section_type_find_sized(ast_t *ast, const char *type, size_t type_size, uint64_t type_hash);
+static ast_node_t *index_section_type_at(ast_node_t *type_node, size_t position, bool from_end);
+static bool index_section_live(const ast_node_t *node);
+static size_t index_child_position_get(ast_node_t *parent, const ast_node_t *node);
+static hash_table_t *index_children_get(ast_node_t *parent);
+static void index_children_filter_rebuild(ast_node_t *parent);
+static uint64_t index_equality_hash_get(uint64_t type_hash, uint64_t option_hash);
+static index_equality_t *index_equality_find(index_t *index, const char *type, uint64_t type_hash, const char *option, uint64_t option_hash);
+static index_equality_t *index_equality_get(ast_t *ast, ast_node_t *type_node, const char *option, uint64_t option_hash);
+static index_equality_t *index_option_equality_find(const ast_node_t *node);
+static void index_equalities_clear(index_t *index);
+static int index_section_position_compare(const void *a, const void *b);
+static const char *index_node_value_get(const ast_node_t *node, uint64_t *value_hash);
+static bool index_node_live(const ast_node_t *node);
+static void index_node_walk(ast_node_t *node, void (*visit)(ast_node_t *node, void *data), void *data);
+static void index_node_values_insert(ast_node_t *node, void *data);
+static void index_node_values_remove(ast_node_t *node, void *data);
+static void index_node_descendant_remove(ast_node_t *node, void *data);
+static void index_node_descendant_restore(ast_node_t *node, void *data);
+static const char *index_node_text_get(const ast_node_t *node);
+static index_trigram_t *index_trigram_find(const hash_table_t *trigrams, const char *trigram, uint64_t trigram_hash);
+static void index_node_trigrams_insert(ast_node_t *node, void *data);
+static void index_node_trigrams_remove(ast_node_t *node, void *data);
+static void index_node_search(ast_node_t *node, void *data);
+static void index_names_insert(ast_t *ast, skip_list_t *names);
+
+void index_destroy(ast_t *ast)
+{
+	assert(ast);
+
+	if (ast->index) {
+		hash_table_destroy(&ast->index->sections);
+		hash_table_destroy(&ast->index->section_types);
+		index_equalities_clear(ast->index);
+		hash_table_destroy(&ast->index->equalities);
+		hash_table_destroy(&ast->index->values);
+		skip_list_destroy(&ast->index->names);
+		for (size_t i = 0; i < ast->index->trigrams.size; i++) {
+			if (ast->index->trigrams.entries[i].value) {
+				hash_table_destroy(&((index_trigram_t *) ast->index->trigrams.entries[i].value)->nodes);
+				XFREE(ast->index->trigrams.entries[i].value);
+			}
+		}
+		hash_table_destroy(&ast->index->trigrams);
+		XFREE(ast->index);
+	}
+}
+
+void index_node_name(ast_node_t *node)
+{
+	assert(node);
+
+	if (node->name == NULL) {
+		return;
+	}
+
+	if (node->type == ANT_SECTION_NAME && node->ast->index) {
+		hash_table_insert(&node->ast->index->sections, node->name_hash, node);
+		if (node->ast->index->names_enabled) {
+			skip_list_insert(&node->ast->index->names, node->name, node);
+		}
+		if (node->ast->index->trigrams_enabled) {
+			index_node_trigrams_insert(node, &node->ast->index->trigrams);
+		}
+	} else if (node->type == ANT_SECTION_TYPE && node->ast->index) {
+		hash_table_insert(&node->ast->index->section_types, node->name_hash, node);
+	} else if (node->type == ANT_OPTION || node->type == ANT_LIST || node->type == ANT_LIST_ITEM) {
+		// the value of a list element is its name, its list indexes it like a section its options
+		if (node->parent && node->parent->children_index) {
+			hash_table_insert(node->parent->children_index, node->name_hash, node);
+		}
+
+		if (node->parent) {
+			node->parent->children_filter |= AST_NODE_FILTER_BITS(node->name_hash);
+		}
+
+		index_node_value(node);
+	}
+}
+
+void index_node_unname(ast_node_t *node)
+{
+	assert(node);
+
+	if (node->name == NULL) {
+		return;
+	}
+
+	if (node->type == ANT_SECTION_NAME && node->ast->index) {
+		hash_table_remove(&node->ast->index->sections, node->name_hash, node);
+		if (node->ast->index->names_enabled) {
+			skip_list_remove(&node->ast->index->names, node->name, node);
+		}
+		if (node->ast->index->trigrams_enabled) {
+			index_node_trigrams_remove(node, &node->ast->index->trigrams);
+		}
+	} else if (node->type == ANT_SECTION_TYPE && node->ast->index) {
+		hash_table_remove(&node->ast->index->section_types, node->name_hash, node);
+		// renaming a section type changes the type of all its sections
+		index_equalities_clear(node->ast->index);
+	} else if (node->type == ANT_OPTION || node->type == ANT_LIST || node->type == ANT_LIST_ITEM) {
+		if (node->parent && node->parent->children_index) {
+			hash_table_remove(node->parent->children_index, node->name_hash, node);
+		}
+
+		// a Bloom filter can not forget a name, the filter is rebuilt once enough names went stale
+		if (node->parent) {
+			node->parent->children_filter_stale++;
+		}
+
+		index_node_unvalue(node);
+	}
+}
+
+void index_node_value(ast_node_t *node)
+{
+	index_equality_t *equality = NULL;
+
+	assert(node);
+
+	equality = index_option_equality_find(node);
+	if (equality && node->value) {
+		hash_table_insert(&equality->values, node->value_hash, node);
+	}
+
+	if (node->ast->index && node->ast->index->values_enabled) {
+		index_node_values_insert(node, &node->ast->index->values);
+	}
+
+	if (node->ast->index && node->ast->index->trigrams_enabled && node->type != ANT_SECTION_NAME) {
+		index_node_trigrams_insert(node, &node->ast->index->trigrams);
+	}
+}
+
+void index_node_unvalue(ast_node_t *node)
+{
+	index_equality_t *equality = NULL;
+
+	assert(node);
+
+	equality = index_option_equality_find(node);
+	if (equality && node->value) {
+		hash_table_remove(&equality->values, node->value_hash, node);
+	}
+
+	if (node->ast->index && node->ast->index->values_enabled) {
+		index_node_values_remove(node, &node->ast->index->values);
+	}
+
+	if (node->ast->index && node->ast->index->trigrams_enabled && node->type != ANT_SECTION_NAME) {
+		index_node_trigrams_remove(node, &node->ast->index->trigrams);
+	}
+}
+
+void index_node_remove(ast_node_t *node)
+{
+	assert(node);
+
+	// a removed node is no longer reachable under any name, a section type is only removed by merging into one with the same name
+	if (node->type == ANT_SECTION_TYPE && node->name && node->ast->index) {
+		hash_table_remove(&node->ast->index->section_types, node->name_hash, node);
+	} else {
+		index_node_unname(node);
+	}
+
+	// values and options below a removed section or list go with it, merged nodes have no children left
+	if (node->ast->index && (node->ast->index->values_enabled || node->ast->index->trigrams_enabled || node->ast->index->equalities.entries_number)) {
+		for (size_t i = 0; i < node->children_number; i++) {
+			if (node->children[i]->parent) {
+				index_node_walk(node->children[i], index_node_descendant_remove, node->ast->index);
+			}
+		}
+	}
+}
+
+void index_node_restore(ast_node_t *node)
+{
+	assert(node);
+
+	// undoes index_node_remove, the children were never taken out of the children index of the node
+	index_node_name(node);
+
+	if (node->ast->index && (node->ast->index->values_enabled || node->ast->index->trigrams_enabled || node->ast->index->equalities.entries_number)) {
+		for (size_t i = 0; i < node->children_number; i++) {
+			if (node->children[i]->parent) {
+				index_node_walk(node->children[i], index_node_descendant_restore, node->ast->index);
+			}
+		}
+	}
+}
+
+ast_node_t **index_values_find(ast_t *ast, const char *value, size_t *out_number)
+{
+	ast_node_t *node = NULL;
+	ast_node_t *config_node = NULL;
+	ast_node_t **nodes = NULL;
+	const char *node_value = NULL;
+	uint64_t value_hash = 0;
+	size_t nodes_number = 0;
+	size_t nodes_size = 0;
+	size_t position = HASH_TABLE_POSITION_START;
+	hash_table_t scan = {0};
+
+	assert(ast);
+	assert(value);
+	assert(out_number);
+
+	value_hash = hash_string(value);
+
+	// without the index the live nodes with the value are collected by a walk of the tree
+	if (ast->index == NULL || ast->index->values_enabled == false) {
+		config_node = ast_config_get(ast);
+		if (config_node == NULL) {
+			*out_number = 0;
+			return NULL;
+		}
+
+		hash_table_init(&scan);
+		index_node_walk(config_node, index_node_values_insert, &scan);
+	}
+
+	while ((node = hash_table_find(ast->index && ast->index->values_enabled ? &ast->index->values : &scan, value_hash, &position))) {
+		node_value = index_node_value_get(node, NULL);
+		// nodes of removed sections are left behind when they are renamed after the removal
+		if (strcmp(node_value, value) != 0 || index_node_live(node) == false) {
+			continue;
+		}
+
+		if (nodes_number == nodes_size) {
+			nodes_size = nodes_size ? nodes_size * 2 : 8;
+			nodes = xrealloc(nodes, nodes_size * sizeof(ast_node_t *));
+		}
+
+		nodes[nodes_number++] = node;
+	}
+
+	hash_table_destroy(&scan);
+
+	*out_number = nodes_number;
+
+	return nodes;
+}
+
+void index_values_enable(ast_t *ast)
+{
+	index_t *index = NULL;
+	ast_node_t *config_node = NULL;
+
+	assert(ast);
+
+	index = index_get(ast);
+	if (index->values_enabled) {
+		return;
+	}
+
+	hash_table_init(&index->values);
+
+	config_node = ast_config_get(ast);
+	if (config_node) {
+		index_node_walk(config_node, index_node_values_insert, &index->values);
+	}
+
+	index->values_enabled = true;
+}
+
+ast_node_t **index_sections_ordered(ast_t *ast, const char *from, const char *to, const char *prefix, size_t *out_number)
+{
+	skip_list_t scan = {0};
+	skip_list_t *names = NULL;
+	skip_list_node_t *name = NULL;
+	ast_node_t **nodes = NULL;
+	size_t nodes_number = 0;
+	size_t nodes_size = 0;
+	size_t prefix_size = prefix ? strlen(prefix) : 0;
+
+	assert(ast);
+	assert(out_number);
+
+	// without the index the names are sorted on every call
+	if (ast->index && ast->index->names_enabled) {
+		names = &ast->index->names;
+	} else {
+		skip_list_init(&scan);
+		index_names_insert(ast, &scan);
+		names = &scan;
+	}
+
+	for (name = skip_list_lower_bound(names, prefix ? prefix : from); name; name = name->next[0]) {
+		if ((to && strcmp(name->key, to) >= 0) ||
+			(prefix && strncmp(name->key, prefix, prefix_size) != 0)) {
+			break;
+		}
+
+		if (index_section_live(name->value) == false) {
+			continue;
+		}
+
+		if (nodes_number == nodes_size) {
+			nodes_size = nodes_size ? nodes_size * 2 : 8;
+			nodes = xrealloc(nodes, nodes_size * sizeof(ast_node_t *));
+		}
+
+		nodes[nodes_number++] = name->value;
+	}
+
+	skip_list_destroy(&scan);
+
+	*out_number = nodes_number;
+
+	return nodes;
+}
+
+void index_names_enable(ast_t *ast)
+{
+	index_t *index = NULL;
+
+	assert(ast);
+
+	index = index_get(ast);
+	if (index->names_enabled) {
+		return;
+	}
+
+	skip_list_init(&index->names);
+	index_names_insert(ast, &index->names);
+	index->names_enabled = true;
+}
+
+ast_node_t **index_search(ast_t *ast, const char *substring, size_t *out_number)
+{
+	ast_node_t *config_node = NULL;
+	ast_node_t *node = NULL;
+	index_trigram_t *trigram = NULL;
+	index_trigram_t *trigram_min = NULL;
+	size_t substring_size = 0;
+	index_search_t search = {0};
+
+	assert(ast);
+	assert(substring);
+	assert(out_number);
+
+	search.substring = substring;
+	substring_size = strlen(substring);
+
+	config_node = ast_config_get(ast);
+	if (config_node == NULL) {
+		*out_number = 0;
+		return NULL;
+	}
+
+	// without the index, or for substrings shorter than a trigram, every text is searched
+	if (ast->index == NULL || ast->index->trigrams_enabled == false || substring_size < 3) {
+		index_node_walk(config_node, index_node_search, &search);
+		*out_number = search.nodes_number;
+		return search.nodes;
+	}
+
+	// the nodes with the rarest trigram of the substring are the candidates
+	for (size_t i = 0; i + 3 <= substring_size; i++) {
+		trigram = index_trigram_find(&ast->index->trigrams, substring + i, hash_bytes(substring + i, 3));
+		if (trigram == NULL) {
+			*out_number = 0;
+			return NULL;
+		}
+
+		if (trigram_min == NULL || trigram->nodes.entries_number < trigram_min->nodes.entries_number) {
+			trigram_min = trigram;
+		}
+	}
+
+	for (size_t i = 0; i < trigram_min->nodes.size; i++) {
+		node = trigram_min->nodes.entries[i].value;
+		if (node && index_node_live(node)) {
+			index_node_search(node, &search);
+		}
+	}
+
+	*out_number = search.nodes_number;
+
+	return search.nodes;
+}
+
+void index_trigrams_enable(ast_t *ast)
+{
+	index_t *index = NULL;
+	ast_node_t *config_node = NULL;
+
+	assert(ast);
+
+	index = index_get(ast);
+	if (index->trigrams_enabled) {
+		return;
+	}
+
+	hash_table_init(&index->trigrams);
+
+	config_node = ast_config_get(ast);
+	if (config_node) {
+		index_node_walk(config_node, index_node_trigrams_insert, &index->trigrams);
+	}
+
+	index->trigrams_enabled = true;
+}
+
+size_t index_memory_get(ast_t *ast)
+{
+	index_t *index = NULL;
+	index_equality_t *equality = NULL;
+	size_t memory = 0;
+
+	assert(ast);
+
+	index = ast->index;
+	if (index) {
+		memory += sizeof(index_t);
+		memory += hash_table_memory_get(&index->sections);
+		memory += hash_table_memory_get(&index->section_types);
+		memory += hash_table_memory_get(&index->equalities);
+		memory += hash_table_memory_get(&index->values);
+		if (index->names_enabled) {
+			memory += skip_list_memory_get(&index->names);
+		}
+
+		memory += hash_table_memory_get(&index->trigrams);
+		for (size_t i = 0; i < index->trigrams.size; i++) {
+			if (index->trigrams.entries[i].value) {
+				memory += sizeof(index_trigram_t) + hash_table_memory_get(&((index_trigram_t *) index->trigrams.entries[i].value)->nodes);
+			}
+		}
+
+		for (size_t i = 0; i < index->equalities.size; i++) {
+			equality = index->equalities.entries[i].value;
+			if (equality) {
+				memory += sizeof(index_equality_t) + strlen(equality->type) + strlen(equality->option) + 2;
+				memory += hash_table_memory_get(&equality->values);
+			}
+		}
+	}
+
+	// the per node indexes are kept in the node pool
+	if (ast->pool) {
+		for (size_t i = 0; i < ast->pool->children_number; i++) {
+			if (ast->pool->children[i]->children_index) {
+				memory += sizeof(hash_table_t) + hash_table_memory_get(ast->pool->children[i]->children_index);
+			}
+
+			if (ast->pool->children[i]->children_sequence) {
+				memory += sizeof(sequence_t);
+			}
+		}
+	}
+
+	return memory;
+}
+
+ast_node_t *index_section_find(ast_t *ast, const char *name, uint64_t name_hash)
+{
+	index_t *index = NULL;
+	ast_node_t *node = NULL;
+	ast_node_t *found = NULL;
+	size_t position = HASH_TABLE_POSITION_START;
+	size_t found_type_position = 0;
+	size_t type_position = 0;
+
+	assert(ast);
+	assert(name);
+
+	index = index_get(ast);
+
+	while ((node = hash_table_find(&index->sections, name_hash, &position))) {
+		if (index_section_live(node) == false ||
+			ast_node_name_equal(node, name, name_hash) == false) {
+			continue;
+		}
+
+		if (found == NULL) {
+			found = node;
+			continue;
+		}
+
+		// duplicate names across section types or from parsing, the first one in config order wins
+		found_type_position = index_child_position_get(found->parent->parent, found->parent);
+		type_position = index_child_position_get(node->parent->parent, node->parent);
+		if (type_position < found_type_position ||
+			(type_position == found_type_position &&
+			 index_child_position_get(node->parent, node) < index_child_position_get(found->parent, found))) {
+			found = node;
+		}
+	}
+
+	return found;
+}
+
+ast_node_t *index_section_get(ast_t *ast, const char *section, uint64_t section_hash)
+{
+	ast_node_t *node = NULL;
+	ast_node_t *type_node = NULL;
+	size_t type_size = 0;
+	size_t position = 0;
+	bool from_end = false;
+
+	assert(ast);
+	assert(section);
+
+	// a section parsed with a name starting with @ is still found by that name
+	node = index_section_find(ast, section, section_hash);
+	if (node || section[0] != '@') {
+		return node;
+	}
+
+	// @type[N] is resolved against the live order of the type, not stored as a name
+	if (index_section_selector_parse(section, strlen(section), &type_size, &position, &from_end) == false) {
+		return NULL;
+	}
+
+	type_node = index_section_type_find_sized(ast, section + 1, type_size, hash_bytes(section + 1, type_size));
+	if (type_node == NULL) {
+		return NULL;
+	}
+
+	return index_section_type_at(type_node, position, from_end);
+}
+
+bool index_section_selector_parse(const char *selector, size_t selector_size, size_t *type_size, size_t *position, bool *from_end)
+{
+	const char *bracket = NULL;
+	size_t i = 0;
+
+	assert(selector);
+	assert(type_size);
+	assert(position);
+	assert(from_end);
+
+	*position = 0;
+	*from_end = false;
+
+	// @type[N] counts live sections of the type from the start, @type[-N] from the end
+	if (selector_size == 0 || selector[0] != '@') {
+		return false;
+	}
+
+	bracket = memchr(selector, '[', selector_size);
+	if (bracket == NULL || bracket == selector + 1 || selector[selector_size - 1] != ']') {
+		return false;
+	}
+
+	i = (size_t) (bracket - selector) + 1;
+	if (selector[i] == '-') {
+		*from_end = true;
+		i++;
+	}
+
+	if (i == selector_size - 1) {
+		return false;
+	}
+
+	for (; i < selector_size - 1; i++) {
+		if (selector[i] < '0' || selector[i] > '9' ||
+			*position > (SIZE_MAX - (size_t) (selector[i] - '0')) / 10) {
+			return false;
+		}
+		*position = *position * 10 + (size_t) (selector[i] - '0');
+	}
+
+	if (*from_end && *position == 0) {
+		return false;
+	}
+
+	*type_size = (size_t) (bracket - selector) - 1;
+
+	return true;
+}
+
+ast_node_t *index_section_type_find(ast_t *ast, const char *type, uint64_t type_hash)
+{
+	assert(ast);
+	assert(type);
+
+	return index_section_type_find_sized(ast, type, strlen(type), type_hash);
+}
+
+ast_node_t *index_type_section_find(ast_node_t *type_node, const char *name, uint64_t name_hash)
+{
+	index_t *index = NULL;
+	ast_node_t *node = NULL;
+	size_t position = HASH_TABLE_POSITION_START;
+
+	assert(type_node);
+	assert(name);
+
+	index = index_get(type_node->ast);
+
+	// sections of all types share the name table, only those of this type count
+	while ((node = hash_table_find(&index->sections, name_hash, &position))) {
+		if (node->parent == type_node && ast_node_name_equal(node, name, name_hash)) {
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+void index_section_detach(ast_node_t *node)
+{
+	assert(node);
+
+	// equality indexes are kept per section type, the options follow their section
+	for (size_t i = 0; i < node->children_number; i++) {
+		if (node->children[i]->parent && node->children[i]->type == ANT_OPTION) {
+			index_node_unvalue(node->children[i]);
+		}
+	}
+}
+
+void index_section_attach(ast_node_t *node)
+{
+	assert(node);
+
+	for (size_t i = 0; i < node->children_number; i++) {
+		if (node->children[i]->parent && node->children[i]->type == ANT_OPTION) {
+			index_node_value(node->children[i]);
+		}
+	}
+}
+
+ast_node_t *index_section_at(ast_t *ast, const char *type, uint64_t type_hash, size_t position, bool from_end)
+{
+	ast_node_t *type_node = NULL;
+
+	type_node = index_section_type_find(ast, type, type_hash);
+	if (type_node == NULL) {
+		return NULL;
+	}
+
+	return index_section_type_at(type_node, position, from_end);
+}
+
+ast_node_t *index_child_find(ast_node_t *parent, const char *name, uint64_t name_hash)
+{
+	hash_table_t *children_index = NULL;
+	ast_node_t *node = NULL;
+	ast_node_t *found = NULL;
+	size_t position = HASH_TABLE_POSITION_START;
+
+	assert(parent);
+	assert(name);
+
+	// most probes for missing options end here without touching the children
+	if ((parent->children_filter & AST_NODE_FILTER_BITS(name_hash)) != AST_NODE_FILTER_BITS(name_hash)) {
+		return NULL;
+	}
+
+	children_index = index_children_get(parent);
+	if (children_index == NULL) {
+		for (size_t i = 0; i < parent->children_number; i++) {
+			if (parent->children[i]->parent &&
+				ast_node_name_equal(parent->children[i], name, name_hash)) {
+				found = parent->children[i];
+				break;
+			}
+		}
+	} else {
+		while ((node = hash_table_find(children_index, name_hash, &position))) {
+			if (node->parent == NULL ||
+				ast_node_name_equal(node, name, name_hash) == false) {
+				continue;
+			}
+
+			// a renamed child sits after the children named before it, the first one in the section wins
+			if (found == NULL ||
+				index_child_position_get(parent, node) < index_child_position_get(parent, found)) {
+				found = node;
+			}
+		}
+	}
+
+	if (found == NULL && parent->children_filter_stale * 4 >= parent->children_number) {
+		index_children_filter_rebuild(parent);
+	}
+
+	return found;
+}
+
+ast_node_t **index_sections_select(ast_t *ast, const char *type, const uci2_predicate_t *predicates, size_t predicates_number, size_t *out_number)
+{
+	ast_node_t *type_node = NULL;
+	ast_node_t *node = NULL;
+	ast_node_t *section_node = NULL;
+	ast_node_t *option_node = NULL;
+	ast_node_t **nodes = NULL;
+	sequence_t *sequence = NULL;
+	sequence_link_t *link = NULL;
+	index_equality_t **equalities = NULL;
+	uint64_t *value_hashes = NULL;
+	size_t candidates_number = 0;
+	size_t candidates_number_min = SIZE_MAX;
+	size_t driver = 0;
+	size_t nodes_number = 0;
+	size_t position = 0;
+	size_t i = 0;
+	struct {
+		size_t position;
+		ast_node_t *node;
+	} *sections = NULL;
+
+	assert(ast);
+	assert(type);
+	assert(out_number);
+
+	*out_number = 0;
+
+	type_node = index_section_type_find(ast, type, hash_string(type));
+	if (type_node == NULL) {
+		return NULL;
+	}
+
+	sequence = ast_node_children_sequence_get(type_node);
+	if (predicates_number == 0) {
+		nodes = xmalloc((sequence_size_get(sequence) + 1) * sizeof(ast_node_t *));
+		for (link = sequence_first(sequence); link; link = sequence_next(link)) {
+			nodes[nodes_number++] = AST_NODE_FROM_LINK(link);
+		}
+
+		*out_number = nodes_number;
+
+		return nodes;
+	}
+
+	// the predicate with the fewest options holding its value drives the selection
+	equalities = xcalloc(predicates_number, sizeof(index_equality_t *));
+	value_hashes = xcalloc(predicates_number, sizeof(uint64_t));
+	for (i = 0; i < predicates_number; i++) {
+		equalities[i] = index_equality_get(ast, type_node, predicates[i].option, hash_string(predicates[i].option));
+		value_hashes[i] = hash_string(predicates[i].value);
+
+		candidates_number = 0;
+		position = HASH_TABLE_POSITION_START;
+		while (candidates_number < candidates_number_min &&
+			   hash_table_find(&equalities[i]->values, value_hashes[i], &position)) {
+			candidates_number++;
+		}
+
+		if (candidates_number < candidates_number_min) {
+			candidates_number_min = candidates_number;
+			driver = i;
+		}
+	}
+
+	sections = xmalloc((candidates_number_min + 1) * sizeof(*sections));
+	position = HASH_TABLE_POSITION_START;
+	while ((node = hash_table_find(&equalities[driver]->values, value_hashes[driver], &position))) {
+		// only the first live option with the name counts, as in index_child_find
+		section_node = node->parent;
+		if (section_node == NULL ||
+			section_node->parent != type_node ||
+			strcmp(node->value, predicates[driver].value) != 0 ||
+			index_child_find(section_node, predicates[driver].option, equalities[driver]->option_hash) != node) {
+			continue;
+		}
+
+		for (i = 0; i < predicates_number; i++) {
+			if (i == driver) {
+				continue;
+			}
+
+			option_node = index_child_find(section_node, predicates[i].option, equalities[i]->option_hash);
+			if (option_node == NULL ||
+				option_node->type != ANT_OPTION ||
+				option_node->value == NULL ||
+				strcmp(option_node->value, predicates[i].value) != 0) {
+				break;
+			}
+		}
+
+		if (i < predicates_number) {
+			continue;
+		}
+
+		sections[nodes_number].position = sequence_position_get(&section_node->sibling_link);
+		sections[nodes_number].node = section_node;
+		nodes_number++;
+	}
+
+	// matches come in the order their values were set, return them in config order
+	qsort(sections, nodes_number, sizeof(*sections), index_section_position_compare);
+
+	nodes = xmalloc((nodes_number + 1) * sizeof(ast_node_t *));
+	for (i = 0; i < nodes_number; i++) {
+		nodes[i] = sections[i].node;
+	}
+
+	*out_number = nodes_number;
+
+	XFREE(sections);
+	XFREE(value_hashes);
+	XFREE(equalities);
+
+	return nodes;
+}
+
+static index_t *index_get(ast_t *ast)
+{
+	ast_node_t *config_node = NULL;
+	ast_node_t *section_type_node = NULL;
+
+	if (ast->index) {
+		return ast->index;
+	}
+
+	ast->index = xcalloc(1, sizeof(index_t));
+	hash_table_init(&ast->index->sections);
+	hash_table_init(&ast->index->section_types);
+	hash_table_init(&ast->index->equalities);
+
+	config_node = ast_config_get(ast);
+	if (config_node == NULL) {
+		return ast->index;
+	}
+
+	for (size_t i = 0; i < config_node->children_number; i++) {
+		section_type_node = config_node->children[i];
+		if (section_type_node->parent == NULL) {
+			continue;
+		}
+
+		index_node_name(section_type_node);
+
+		for (size_t j = 0; j < section_type_node->children_number; j++) {
+			if (section_type_node->children[j]->parent) {
+				index_node_name(section_type_node->children[j]);
+			}
+		}
+	}
+
+	return ast->index;
+}
+
+static bool index_section_live(const ast_node_t *node)
+{
+	return node->parent &&
+		   node->parent->parent &&
+		   node->parent->parent->parent;
+}
+
+static size_t index_child_position_get(ast_node_t *parent, const ast_node_t *node)
+{
+	// live children only, in O(log n)
+	ast_node_children_sequence_get(parent);
+
+	return sequence_position_get(&node->sibling_link);
+}
+
+static hash_table_t *index_children_get(ast_node_t *parent)
+{
+	if (parent->children_index || parent->children_number < INDEX_CHILDREN_THRESHOLD) {
+		return parent->children_index;
+	}
+
+	parent->children_index = xcalloc(1, sizeof(hash_table_t));
+	hash_table_init(parent->children_index);
+
+	// only the name index is filled, the other indexes already hold the children
+	for (size_t i = 0; i < parent->children_number; i++) {
+		if (parent->children[i]->parent && parent->children[i]->name) {
+			hash_table_insert(parent->children_index, parent->children[i]->name_hash, parent->children[i]);
+		}
+	}
+
+	return parent->children_index;
+}
+
+static void index_children_filter_rebuild(ast_node_t *parent)
+{
+	parent->children_filter = 0;
+	parent->children_filter_stale = 0;
+
+	for (size_t i = 0; i < parent->children_number; i++) {
+		if (parent->children[i]->parent && parent->children[i]->name) {
+			parent->children_filter |= AST_NODE_FILTER_BITS(parent->children[i]->name_hash);
+		}
+	}
+}
+
+static uint64_t index_equality_hash_get(uint64_t type_hash, uint64_t option_hash)
+{
+	return type_hash ^ (option_hash * UINT64_C(0x9e3779b97f4a7c15));
+}
+
+static index_equality_t *index_equality_find(index_t *index, const char *type, uint64_t type_hash, const char *option, uint64_t option_hash)
+{
+	index_equality_t *equality = NULL;
+	size_t position = HASH_TABLE_POSITION_START;
+
+	while ((equality = hash_table_find(&index->equalities, index_equality_hash_get(type_hash, option_hash), &position))) {
+		if (equality->type_hash == type_hash &&
+			equality->option_hash == option_hash &&
+			strcmp(equality->type, type) == 0 &&
+			strcmp(equality->option, option) == 0) {
+			return equality;
+		}
+	}
+
+	return NULL;
+}
+
+static index_equality_t *index_equality_get(ast_t *ast, ast_node_t *type_node, const char *option, uint64_t option_hash)
+{
+	index_t *index = NULL;
+	index_equality_t *equality = NULL;
+	sequence_link_t *link = NULL;
+	ast_node_t *section_node = NULL;
+
+	index = index_get(ast);
+	equality = index_equality_find(index, type_node->name, type_node->name_hash, option, option_hash);
+	if (equality) {
+		return equality;
+	}
+
+	equality = xcalloc(1, sizeof(index_equality_t));
+	equality->type = xstrdup(type_node->name);
+	equality->type_hash = type_node->name_hash;
+	equality->option = xstrdup(option);
+	equality->option_hash = option_hash;
+	hash_table_init(&equality->values);
+
+	for (link = sequence_first(ast_node_children_sequence_get(type_node)); link; link = sequence_next(link)) {
+		section_node = AST_NODE_FROM_LINK(link);
+		for (size_t i = 0; i < section_node->children_number; i++) {
+			if (section_node->children[i]->parent &&
+				section_node->children[i]->type == ANT_OPTION &&
+				section_node->children[i]->value &&
+				ast_node_name_equal(section_node->children[i], option, option_hash)) {
+				hash_table_insert(&equality->values, section_node->children[i]->value_hash, section_node->children[i]);
+			}
+		}
+	}
+
+	hash_table_insert(&index->equalities, index_equality_hash_get(equality->type_hash, option_hash), equality);
+
+	return equality;
+}
+
+static index_equality_t *index_option_equality_find(const ast_node_t *node)
+{
+	// options of removed sections are taken out with the section, only live options are found here
+	if (node->type != ANT_OPTION ||
+		node->name == NULL ||
+		node->ast->index == NULL ||
+		node->ast->index->equalities.entries_number == 0 ||
+		node->parent == NULL ||
+		node->parent->parent == NULL ||
+		node->parent->parent->name == NULL) {
+		return NULL;
+	}
+
+	return index_equality_find(node->ast->index, node->parent->parent->name, node->parent->parent->name_hash, node->name, node->name_hash);
+}
+
+static void index_equalities_clear(index_t *index)
+{
+	index_equality_t *equality = NULL;
+
+	for (size_t i = 0; i < index->equalities.size; i++) {
+		equality = index->equalities.entries[i].value;
+		if (equality) {
+			hash_table_destroy(&equality->values);
+			XFREE(equality->type);
+			XFREE(equality->option);
+			XFREE(equality);
+		}
+	}
+
+	hash_table_destroy(&index->equalities);
+	hash_table_init(&index->equalities);
+}
+
+static int index_section_position_compare(const void *a, const void *b)
+{
+	const size_t *position_a = a;
+	const size_t *position_b = b;
+
+	return (*position_a > *position_b) - (*position_a < *position_b);
+}
+
+static const char *index_node_value_get(const ast_node_t *node, uint64_t *value_hash)
+{
+	if (node->type == ANT_OPTION) {
+		if (value_hash) {
+			*value_hash = node->value_hash;
+		}
+
+		return node->value;
+	}
+
+	if (node->type == ANT_LIST_ITEM) {
+		if (value_hash) {
+			*value_hash = node->name_hash;
+		}
+
+		return node->name;
+	}
+
+	return NULL;
+}
+
+static bool index_node_live(const ast_node_t *node)
+{
+	const ast_t *ast = node->ast;
+
+	// removing a node detaches only the node itself, not its children
+	for (; node; node = node->parent) {
+		if (node == ast->root) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void index_node_walk(ast_node_t *node, void (*visit)(ast_node_t *node, void *data), void *data)
+{
+	visit(node, data);
+
+	for (size_t i = 0; i < node->children_number; i++) {
+		if (node->children[i]->parent) {
+			index_node_walk(node->children[i], visit, data);
+		}
+	}
+}
+
+static void index_node_values_insert(ast_node_t *node, void *data)
+{
+	uint64_t value_hash = 0;
+
+	if (index_node_value_get(node, &value_hash)) {
+		hash_table_insert(data, value_hash, node);
+	}
+}
+
+static void index_node_values_remove(ast_node_t *node, void *data)
+{
+	uint64_t value_hash = 0;
+
+	if (index_node_value_get(node, &value_hash)) {
+		hash_table_remove(data, value_hash, node);
+	}
+}
+
+static ast_node_t *index_section_type_find_sized(ast_t *ast, const char *type, size_t type_size, uint64_t type_hash)
+{
+	index_t *index = NULL;
+	ast_node_t *node = NULL;
+	size_t position = HASH_TABLE_POSITION_START;
+
+	index = index_get(ast);
+
+	// section types with the same name are merged, at most one of them is live
+	while ((node = hash_table_find(&index->section_types, type_hash, &position))) {
+		if (node->parent &&
+			node->parent->parent &&
+			node->name_hash == type_hash &&
+			strncmp(node->name, type, type_size) == 0 &&
+			node->name[type_size] == '\0') {
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+static ast_node_t *index_section_type_at(ast_node_t *type_node, size_t position, bool from_end)
+{
+	sequence_t *sequence = NULL;
+	size_t size = 0;
+
+	// positions count live sections only, from_end counts from 1 like @type[-1]
+	sequence = ast_node_children_sequence_get(type_node);
+	size = sequence_size_get(sequence);
+	if (from_end) {
+		if (position == 0 || position > size) {
+			return NULL;
+		}
+		position = size - position;
+	}
+
+	if (position >= size) {
+		return NULL;
+	}
+
+	return AST_NODE_FROM_LINK(sequence_at(sequence, position));
+}
+
+static void index_names_insert(ast_t *ast, skip_list_t *names)
+{
+	ast_node_t *config_node = NULL;
+	ast_node_t *section_type_node = NULL;
+	ast_node_t *section_node = NULL;
+
+	config_node = ast_config_get(ast);
+	if (config_node == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < config_node->children_number; i++) {
+		section_type_node = config_node->children[i];
+		if (section_type_node->parent == NULL) {
+			continue;
+		}
+
+		for (size_t j = 0; j < section_type_node->children_number; j++) {
+			section_node = section_type_node->children[j];
+			if (section_node->parent && section_node->name) {
+				skip_list_insert(names, section_node->name, section_node);
+			}
+		}
+	}
+}
+
+static void index_node_descendant_remove(ast_node_t *node, void *data)
+{
+	index_t *index = data;
+	index_equality_t *equality = NULL;
+
+	// the option is still attached, so its section type is known
+	equality = index_option_equality_find(node);
+	if (equality && node->value) {
+		hash_table_remove(&equality->values, node->value_hash, node);
+	}
+
+	if (index->values_enabled) {
+		index_node_values_remove(node, &index->values);
+	}
+
+	if (index->trigrams_enabled) {
+		index_node_trigrams_remove(node, &index->trigrams);
+	}
+}
+
+static void index_node_descendant_restore(ast_node_t *node, void *data)
+{
+	index_t *index = data;
+	index_equality_t *equality = NULL;
+
+	equality = index_option_equality_find(node);
+	if (equality && node->value) {
+		hash_table_insert(&equality->values, node->value_hash, node);
+	}
+
+	if (index->values_enabled) {
+		index_node_values_insert(node, &index->values);
+	}
+
+	if (index->trigrams_enabled) {
+		index_node_trigrams_insert(node, &index->trigrams);
+	}
+}
+
+static const char *index_node_text_get(const ast_node_t *node)
+{
+	if (node->type == ANT_SECTION_NAME) {
+		return node->name;
+	}
+
+	return index_node_value_get(node, NULL);
+}
+
+static index_trigram_t *index_trigram_find(const hash_table_t *trigrams, const char *trigram, uint64_t trigram_hash)
+{
+	index_trigram_t *found = NULL;
+	size_t position = HASH_TABLE_POSITION_START;
+
+	while ((found = hash_table_find(trigrams, trigram_hash, &position))) {
+		if (memcmp(found->trigram, trigram, 3) == 0) {
+			return found;
+		}
+	}
+
+	return NULL;
+}
+
+static void index_node_trigrams_insert(ast_node_t *node, void *data)
+{
+	hash_table_t *trigrams = data;
+	index_trigram_t *trigram = NULL;
+	const char *text = index_node_text_get(node);
+	uint64_t node_hash = hash_bytes(&node, sizeof(node));
+	uint64_t trigram_hash = 0;
+	size_t position = 0;
+
+	if (text == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; text[i] && text[i + 1] && text[i + 2]; i++) {
+		trigram_hash = hash_bytes(text + i, 3);
+		trigram = index_trigram_find(trigrams, text + i, trigram_hash);
+		if (trigram == NULL) {
+			trigram = xcalloc(1, sizeof(index_trigram_t));
+			memcpy(trigram->trigram, text + i, 3);
+			hash_table_init(&trigram->nodes);
+			hash_table_insert(trigrams, trigram_hash, trigram);
+		}
+
+		// a trigram repeated in the text holds the node once
+		position = HASH_TABLE_POSITION_START;
+		if (hash_table_find(&trigram->nodes, node_hash, &position) == NULL) {
+			hash_table_insert(&trigram->nodes, node_hash, node);
+		}
+	}
+}
+
+static void index_node_trigrams_remove(ast_node_t *node, void *data)
+{
+	hash_table_t *trigrams = data;
+	index_trigram_t *trigram = NULL;
+	const char *text = index_node_text_get(node);
+	uint64_t node_hash = hash_bytes(&node, sizeof(node));
+	uint64_t trigram_hash = 0;
+
+	if (text == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; text[i] && text[i + 1] && text[i + 2]; i++) {
+		trigram_hash = hash_bytes(text + i, 3);
+		trigram = index_trigram_find(trigrams, text + i, trigram_hash);
+		if (trigram == NULL || hash_table_remove(&trigram->nodes, node_hash, node) == false) {
+			continue;
+		}
+
+		if (trigram->nodes.entries_number == 0) {
+			hash_table_remove(trigrams, trigram_hash, trigram);
+			hash_table_destroy(&trigram->nodes);
+			XFREE(trigram);
+		}
+	}
+}
+
+static void index_node_search(ast_node_t *node, void *data)
+{
+	index_search_t *search = data;
+	const char *text = index_node_text_get(node);
+
+	if (text == NULL || strstr(text, search->substring) == NULL) {
+		return;
+	}
+
+	if (search->nodes_number == search->nodes_size) {
+		search->nodes_size = search->nodes_size ? search->nodes_size * 2 : 8;
+		search->nodes = xrealloc(search->nodes, search->nodes_size * sizeof(ast_node_t *));
+	}
+
+	search->nodes[search->nodes_number++] = node;
+}
@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef INDEX_H_ONCE
+#define INDEX_H_ONCE
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils/hash_table.h"
+#include "utils/skip_list.h"
+
+#include "ast.h"
+#include "uci2.h"
+
+// sections with at least this many children get a name index over their options and lists
+#define INDEX_CHILDREN_THRESHOLD (16)
+
+typedef struct index_equality_s index_equality_t;
+typedef struct index_trigram_s index_trigram_t;
+
+// lookup indexes of an AST, built on first use and kept up to date by the ast_node_* functions
+struct index_s {
+	hash_table_t sections;      // section name hash -> ANT_SECTION_NAME node
+	hash_table_t section_types; // section type hash -> ANT_SECTION_TYPE node
+	hash_table_t equalities;    // hash of section type and option name -> index_equality_t
+	bool values_enabled;
+	hash_table_t values; // option and list element value hash -> ANT_OPTION or ANT_LIST_ITEM node, only when enabled
+	bool names_enabled;
+	skip_list_t names; // section name -> ANT_SECTION_NAME node in name order, only when enabled
+	bool trigrams_enabled;
+	hash_table_t trigrams; // trigram hash -> index_trigram_t, over section names, option values and list elements, only when enabled
+};
+
+// options with the same name in sections of the same type, by value
+struct index_equality_s {
+	char *type;
+	uint64_t type_hash;
+	char *option;
+	uint64_t option_hash;
+	hash_table_t values; // option value hash -> ANT_OPTION node
+};
+
+// nodes whose text contains the three bytes
+struct index_trigram_s {
+	char trigram[3];
+	hash_table_t nodes; // node address hash -> ANT_SECTION_NAME, ANT_OPTION or ANT_LIST_ITEM node
+};
+
+void index_destroy(ast_t *ast);
+void index_node_name(ast_node_t *node);
+void index_node_unname(ast_node_t *node);
+void index_node_value(ast_node_t *node);
+void index_node_unvalue(ast_node_t *node);
+void index_node_remove(ast_node_t *node);
+void index_node_restore(ast_node_t *node);
+ast_node_t *index_section_find(ast_t *ast, const char *name, uint64_t name_hash);
+ast_node_t *index_section_get(ast_t *ast, const char *section, uint64_t section_hash);
+bool index_section_selector_parse(const char *selector, size_t selector_size, size_t *type_size, size_t *position, bool *from_end);
+ast_node_t *index_section_type_find(ast_t *ast, const char *type, uint64_t type_hash);
+ast_node_t *index_type_section_find(ast_node_t *type_node, const char *name, uint64_t name_hash);
+void index_section_detach(ast_node_t *node);
+void index_section_attach(ast_node_t *node);
+ast_node_t *index_section_at(ast_t *ast, const char *type, uint64_t type_hash, size_t position, bool from_end);
+ast_node_t *index_child_find(ast_node_t *parent, const char *name, uint64_t name_hash);
+ast_node_t **index_values_find(ast_t *ast, const char *value, size_t *out_number);
+void index_values_enable(ast_t *ast);
+ast_node_t **index_sections_ordered(ast_t *ast, const char *from, const char *to, const char *prefix, size_t *out_number);
+void index_names_enable(ast_t *ast);
+ast_node_t **index_search(ast_t *ast, const char *substring, size_t *out_number);
+void index_trigrams_enable(ast_t *ast);
+size_t index_memory_get(ast_t *ast);
+ast_node_t **index_sections_select(ast_t *ast, const char *type, const uci2_predicate_t *predicates, size_t predicates_number, size_t *out_number);
+
+#endif /* INDEX_H_ONCE */
@@ -0,0 +1,600 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <unistd.h>
+
+#include "utils/debug.h"
+#include "utils/memory.h"
+#include "utils/hash.h"
+
+#include "journal.h"
+#include "index.h"
+#include "txn.h"
+
+// path depth of a list element: section, list and position
+#define JOURNAL_PATH_DEPTH_MAX (3)
+// the path and at most two arguments
+#define JOURNAL_FIELDS_NUMBER_MAX (JOURNAL_PATH_DEPTH_MAX + 2)
+
+static void journal_buffer_append(char **buffer, size_t *length, size_t *size, const char *data, size_t data_length);
+static void journal_field_append(journal_t *journal, const char *field);
+static void journal_write(journal_t *journal, const char *data, size_t data_length);
+static uci2_error_e journal_replay(ast_t *ast, const char *buffer, size_t buffer_size, size_t *valid_size);
+static const char *journal_record_parse(const char *cursor, const char *end, char *operation, size_t *depth, char **fields, size_t *fields_number);
+static uci2_error_e journal_record_apply(ast_t *ast, char operation, size_t depth, char **fields, size_t fields_number);
+static ast_node_t *journal_node_find(ast_t *ast, size_t depth, char **fields);
+
+uci2_error_e journal_open(ast_t *ast, const char *path)
+{
+	uci2_error_e error = UE_NONE;
+	FILE *file = NULL;
+	char *buffer = NULL;
+	long buffer_size = 0;
+	size_t valid_size = 0;
+
+	assert(ast);
+	assert(ast->journal == NULL);
+	assert(ast->txn == NULL);
+	assert(path);
+
+	file = fopen(path, "r");
+	if (file) {
+		if (fseek(file, 0, SEEK_END) != 0 || (buffer_size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+			DEBUG("error reading journal: %s", path);
+			error = UE_FILE_IO;
+			goto error_out;
+		}
+
+		buffer = xmalloc((size_t) buffer_size + 1);
+		if (fread(buffer, 1, (size_t) buffer_size, file) != (size_t) buffer_size) {
+			DEBUG("error reading journal: %s", path);
+			error = UE_FILE_IO;
+			goto error_out;
+		}
+
+		fclose(file);
+		file = NULL;
+	} else if (errno != ENOENT) {
+		DEBUG("error opening journal: %s", path);
+		error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	// a journal that does not apply to the AST leaves it as it was
+	txn_begin(ast);
+	error = journal_replay(ast, buffer, (size_t) buffer_size, &valid_size);
+	if (error) {
+		txn_rollback(ast);
+		goto error_out;
+	}
+	txn_commit(ast);
+
+	// a record cut short while it was appended never took effect
+	if (valid_size < (size_t) buffer_size && truncate(path, (off_t) valid_size) != 0) {
+		DEBUG("error truncating journal: %s", path);
+		error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	file = fopen(path, "a");
+	if (file == NULL) {
+		DEBUG("error opening journal: %s", path);
+		error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	ast->journal = xcalloc(1, sizeof(journal_t));
+	ast->journal->file = file;
+	file = NULL;
+
+	goto out;
+
+error_out:
+out:
+	if (file) {
+		fclose(file);
+	}
+	XFREE(buffer);
+
+	return error;
+}
+
+void journal_record_begin(ast_t *ast, enum journal_operation operation, ast_node_t *node)
+{
+	journal_t *journal = NULL;
+	ast_node_t *section_node = NULL;
+	char header[32] = {0};
+	char position[32] = {0};
+	char *section_name = NULL;
+	size_t section_name_size = 0;
+	size_t depth = 0;
+
+	assert(ast);
+	assert(node);
+
+	// changes made by other changes are part of the outer record
+	journal = ast->journal;
+	if (journal == NULL || journal->depth++ > 0) {
+		return;
+	}
+
+	journal->record_length = 0;
+
+	if (node->type == ANT_LIST_ITEM) {
+		section_node = node->parent->parent;
+		depth = 3;
+	} else if (node->type == ANT_OPTION || node->type == ANT_LIST) {
+		section_node = node->parent;
+		depth = 2;
+	} else if (node->type == ANT_SECTION_NAME) {
+		section_node = node;
+		depth = 1;
+	}
+
+	snprintf(header, sizeof(header), "%c %zu", (char) operation, depth);
+	journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, header, strlen(header));
+
+	// sections go by name if that finds them, otherwise by position within their type
+	if (section_node) {
+		if (section_node->name && index_section_find(ast, section_node->name, section_node->name_hash) == section_node) {
+			journal_field_append(journal, section_node->name);
+		} else {
+			section_name_size = unnamed_section_name_get(section_node, NULL, 0) + 1;
+			section_name = xmalloc(section_name_size);
+			unnamed_section_name_get(section_node, section_name, section_name_size);
+			journal_field_append(journal, section_name);
+			XFREE(section_name);
+		}
+	}
+
+	if (depth == 2) {
+		journal_field_append(journal, node->name);
+	} else if (depth == 3) {
+		journal_field_append(journal, node->parent->name);
+		ast_node_children_sequence_get(node->parent);
+		snprintf(position, sizeof(position), "%zu", sequence_position_get(&node->sibling_link));
+		journal_field_append(journal, position);
+	}
+}
+
+void journal_record_end(ast_t *ast, const char *argument, const char *argument_next)
+{
+	journal_t *journal = NULL;
+
+	assert(ast);
+
+	journal = ast->journal;
+	if (journal == NULL || journal->depth == 0 || --journal->depth > 0) {
+		return;
+	}
+
+	if (argument) {
+		journal_field_append(journal, argument);
+	}
+
+	if (argument_next) {
+		journal_field_append(journal, argument_next);
+	}
+
+	journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, "\n", 1);
+
+	// a transaction may still be rolled back, its records wait for the commit
+	if (ast->txn) {
+		journal_buffer_append(&journal->pending, &journal->pending_length, &journal->pending_size, journal->record, journal->record_length);
+	} else {
+		journal_write(journal, journal->record, journal->record_length);
+	}
+
+	journal->record_length = 0;
+}
+
+void journal_record_cancel(ast_t *ast)
+{
+	journal_t *journal = NULL;
+
+	assert(ast);
+
+	journal = ast->journal;
+	if (journal == NULL || journal->depth == 0) {
+		return;
+	}
+
+	if (--journal->depth == 0) {
+		journal->record_length = 0;
+	}
+}
+
+uci2_error_e journal_flush(ast_t *ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	assert(ast);
+
+	if (ast->journal == NULL) {
+		goto out;
+	}
+
+	if (ast->journal->pending_length) {
+		journal_write(ast->journal, ast->journal->pending, ast->journal->pending_length);
+		ast->journal->pending_length = 0;
+	}
+
+	if (ast->journal->failed) {
+		error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+void journal_discard(ast_t *ast)
+{
+	assert(ast);
+
+	if (ast->journal) {
+		ast->journal->pending_length = 0;
+	}
+}
+
+uci2_error_e journal_truncate(ast_t *ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	assert(ast);
+	assert(ast->journal);
+
+	// the file is open for appending, later records start at the new end
+	if (fflush(ast->journal->file) != 0 || ftruncate(fileno(ast->journal->file), 0) != 0) {
+		DEBUG("error truncating journal (%d): %s", errno, strerror(errno));
+		error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	// the package file holds the records that were lost, the journal starts over
+	ast->journal->failed = false;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+void journal_destroy(ast_t *ast)
+{
+	assert(ast);
+
+	if (ast->journal) {
+		fclose(ast->journal->file);
+		XFREE(ast->journal->record);
+		XFREE(ast->journal->pending);
+		XFREE(ast->journal);
+	}
+}
+
+static void journal_buffer_append(char **buffer, size_t *length, size_t *size, const char *data, size_t data_length)
+{
+	if (*length + data_length > *size) {
+		*size = (*length + data_length) * 2;
+		*buffer = xrealloc(*buffer, *size);
+	}
+
+	memcpy(*buffer + *length, data, data_length);
+	*length += data_length;
+}
+
+static void journal_field_append(journal_t *journal, const char *field)
+{
+	const char *quote = NULL;
+
+	// fields are single quoted, a quote inside one is written as '\'' as in shell
+	journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, " '", 2);
+
+	while ((quote = strchr(field, '\''))) {
+		journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, field, (size_t) (quote - field));
+		journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, "'\\''", 4);
+		field = quote + 1;
+	}
+
+	journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, field, strlen(field));
+	journal_buffer_append(&journal->record, &journal->record_length, &journal->record_size, "'", 1);
+}
+
+static void journal_write(journal_t *journal, const char *data, size_t data_length)
+{
+	// a record after a missing one would be replayed onto the wrong AST
+	if (journal->failed) {
+		return;
+	}
+
+	errno = 0;
+	if (fwrite(data, 1, data_length, journal->file) != data_length || fflush(journal->file) != 0) {
+		DEBUG("error writing journal (%d): %s", errno, strerror(errno));
+		journal->failed = true;
+	}
+}
+
+static uci2_error_e journal_replay(ast_t *ast, const char *buffer, size_t buffer_size, size_t *valid_size)
+{
+	uci2_error_e error = UE_NONE;
+	const char *cursor = buffer;
+	const char *next = NULL;
+	char *fields[JOURNAL_FIELDS_NUMBER_MAX] = {0};
+	size_t fields_number = 0;
+	size_t depth = 0;
+	char operation = 0;
+
+	*valid_size = 0;
+
+	while (cursor && cursor < buffer + buffer_size) {
+		next = journal_record_parse(cursor, buffer + buffer_size, &operation, &depth, fields, &fields_number);
+		if (next == NULL) {
+			// only the last record can be incomplete
+			if (memchr(cursor, '\n', (size_t) (buffer + buffer_size - cursor))) {
+				DEBUG("malformed journal record at offset %zu", (size_t) (cursor - buffer));
+				error = UE_PARSER;
+			}
+			goto out;
+		}
+
+		error = journal_record_apply(ast, operation, depth, fields, fields_number);
+		for (size_t i = 0; i < fields_number; i++) {
+			XFREE(fields[i]);
+		}
+		if (error) {
+			DEBUG("journal record at offset %zu does not apply", (size_t) (cursor - buffer));
+			error = UE_PARSER;
+			goto out;
+		}
+
+		cursor = next;
+		*valid_size = (size_t) (cursor - buffer);
+	}
+
+out:
+	return error;
+}
+
+static const char *journal_record_parse(const char *cursor, const char *end, char *operation, size_t *depth, char **fields, size_t *fields_number)
+{
+	char *field = NULL;
+	size_t field_length = 0;
+	size_t field_size = 0;
+	const char *quote = NULL;
+
+	*fields_number = 0;
+
+	if (end - cursor < 3 || cursor[1] != ' ' || cursor[2] < '0' || cursor[2] > '0' + JOURNAL_PATH_DEPTH_MAX) {
+		goto error_out;
+	}
+
+	*operation = cursor[0];
+	*depth = (size_t) (cursor[2] - '0');
+	cursor += 3;
+
+	while (cursor < end && *cursor != '\n') {
+		if (end - cursor < 2 || cursor[0] != ' ' || cursor[1] != '\'' || *fields_number == JOURNAL_FIELDS_NUMBER_MAX) {
+			goto error_out;
+		}
+		cursor += 2;
+
+		field = NULL;
+		field_length = 0;
+		field_size = 0;
+		for (;;) {
+			quote = memchr(cursor, '\'', (size_t) (end - cursor));
+			if (quote == NULL) {
+				goto error_out;
+			}
+
+			journal_buffer_append(&field, &field_length, &field_size, cursor, (size_t) (quote - cursor));
+			cursor = quote + 1;
+
+			if (end - cursor >= 3 && strncmp(cursor, "\\''", 3) == 0) {
+				journal_buffer_append(&field, &field_length, &field_size, "'", 1);
+				cursor += 3;
+				continue;
+			}
+
+			break;
+		}
+
+		journal_buffer_append(&field, &field_length, &field_size, "", 1);
+		fields[(*fields_number)++] = field;
+		field = NULL;
+	}
+
+	if (cursor == end || *fields_number < *depth) {
+		goto error_out;
+	}
+
+	return cursor + 1;
+
+error_out:
+	XFREE(field);
+	for (size_t i = 0; i < *fields_number; i++) {
+		XFREE(fields[i]);
+	}
+	*fields_number = 0;
+
+	return NULL;
+}
+
+static uci2_error_e journal_record_apply(ast_t *ast, char operation, size_t depth, char **fields, size_t fields_number)
+{
+	uci2_error_e error = UE_NONE;
+	ast_node_t *node = NULL;
+	ast_node_t *new_node = NULL;
+	char **arguments = fields + depth;
+	size_t arguments_number = fields_number - depth;
+	char *position_end = NULL;
+	unsigned long position = 0;
+
+	node = journal_node_find(ast, depth, fields);
+	if (node == NULL) {
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	switch (operation) {
+		case JO_SECTION_ADD:
+			if (arguments_number < 1 || arguments_number > 2) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_section_add(ast, node, arguments[0], arguments_number == 2 ? arguments[1] : NULL, &new_node);
+			break;
+
+		case JO_OPTION_ADD:
+			if (arguments_number != 2) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_option_add(ast, node, arguments[0], arguments[1], &new_node);
+			break;
+
+		case JO_LIST_ADD:
+			if (arguments_number != 1) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_list_add(ast, node, arguments[0], &new_node);
+			break;
+
+		case JO_LIST_ELEMENT_ADD:
+			if (arguments_number != 1) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_list_element_add(ast, node, arguments[0], &new_node);
+			break;
+
+		case JO_TYPE_SET:
+			if (arguments_number != 1) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_section_type_set(node, arguments[0]);
+			break;
+
+		case JO_NAME_SET:
+			if (arguments_number != 1) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			if (node->type == ANT_SECTION_NAME) {
+				error = uci2_node_section_name_set(node, arguments[0]);
+			} else if (node->type == ANT_OPTION) {
+				error = uci2_node_option_name_set(node, arguments[0]);
+			} else {
+				error = uci2_node_list_name_set(node, arguments[0]);
+			}
+			break;
+
+		case JO_VALUE_SET:
+			if (arguments_number != 1) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			if (node->type == ANT_OPTION) {
+				error = uci2_node_option_value_set(node, arguments[0]);
+			} else {
+				error = uci2_node_list_element_value_set(node, arguments[0]);
+			}
+			break;
+
+		case JO_REMOVE:
+			if (arguments_number != 0 || depth == 0) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			uci2_node_remove(node);
+			break;
+
+		case JO_LIST_VALUE_REMOVE:
+			if (arguments_number != 1) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_list_remove_value(node, arguments[0]);
+			break;
+
+		case JO_LIST_UNIQUE:
+			if (arguments_number != 0) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_list_unique(node);
+			break;
+
+		case JO_POSITION_SET:
+			if (arguments_number != 1 || depth == 0) {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			errno = 0;
+			position = strtoul(arguments[0], &position_end, 10);
+			if (errno || *position_end != '\0') {
+				error = UE_PARSER;
+				goto error_out;
+			}
+			error = uci2_node_set_position(node, (size_t) position);
+			break;
+
+		default:
+			DEBUG("unknown journal operation: %c", operation);
+			error = UE_PARSER;
+			goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+static ast_node_t *journal_node_find(ast_t *ast, size_t depth, char **fields)
+{
+	ast_node_t *node = NULL;
+	sequence_t *sequence = NULL;
+	sequence_link_t *link = NULL;
+	char *position_end = NULL;
+	unsigned long position = 0;
+
+	if (uci2_node_get(ast, depth > 0 ? fields[0] : NULL, depth > 1 ? fields[1] : NULL, &node) != UE_NONE) {
+		return NULL;
+	}
+
+	if (depth < 3) {
+		return node;
+	}
+
+	if (node->type != ANT_LIST) {
+		return NULL;
+	}
+
+	errno = 0;
+	position = strtoul(fields[2], &position_end, 10);
+	if (errno || *position_end != '\0') {
+		return NULL;
+	}
+
+	sequence = ast_node_children_sequence_get(node);
+	link = sequence_at(sequence, (size_t) position);
+
+	return link ? AST_NODE_FROM_LINK(link) : NULL;
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef JOURNAL_H_ONCE
+#define JOURNAL_H_ONCE
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "uci2.h"
+
+// first character of a journal record, followed by the path depth, the path and the arguments
+enum journal_operation {
+	JO_SECTION_ADD = 'A',
+	JO_OPTION_ADD = 'O',
+	JO_LIST_ADD = 'L',
+	JO_LIST_ELEMENT_ADD = 'E',
+	JO_TYPE_SET = 'T',
+	JO_NAME_SET = 'S',
+	JO_VALUE_SET = 'V',
+	JO_REMOVE = 'R',
+	JO_LIST_VALUE_REMOVE = 'X',
+	JO_LIST_UNIQUE = 'U',
+	JO_POSITION_SET = 'P'
+};
+
+// append-only log of the changes made since the package file was written, one line per change
+struct journal_s {
+	FILE *file;
+	// record being built, only the outermost of nested changes is written
+	char *record;
+	size_t record_length;
+	size_t record_size;
+	size_t depth;
+	// records of the open transaction, written when it is committed
+	char *pending;
+	size_t pending_length;
+	size_t pending_size;
+	// a record could not be written, later ones are not written either until the journal is emptied
+	bool failed;
+};
+
+uci2_error_e journal_open(ast_t *ast, const char *path);
+void journal_record_begin(ast_t *ast, enum journal_operation operation, ast_node_t *node);
+void journal_record_end(ast_t *ast, const char *argument, const char *argument_next);
+void journal_record_cancel(ast_t *ast);
+uci2_error_e journal_flush(ast_t *ast);
+void journal_discard(ast_t *ast);
+uci2_error_e journal_truncate(ast_t *ast);
+void journal_destroy(ast_t *ast);
+
+#endif /* JOURNAL_H_ONCE */
@@ -481,13 +481,21 @@ static const flex_int16_t yy_chk[131] =
 	#include <stdio.h>
 
 	#include "utils/memory.h"
+	#include "utils/hash.h"
 
 	#include "parser.h"
-	char *uci_unquote(char *string, int string_size);
-#line 487 "lexer.c"
+	#include "scanner.h"
+	char *uci_unquote(char *string, int string_size, uint64_t *hash);
+
+	// read input through the scanner input source (yyextra) in chunks
+	// strings set up with yy_scan_string never reach YY_INPUT
+	#define YY_INPUT(buffer, result, max_size) result = scanner_input_read(yyextra, buffer, (size_t) max_size)
+	// track line and column of every matched token for diagnostics
+	#define YY_USER_ACTION scanner_input_locate(yyextra, yytext, (size_t) yyleng);
+#line 495 "lexer.c"
 #define YY_NO_INPUT 1
 
-#line 490 "lexer.c"
+#line 498 "lexer.c"
 
 #define INITIAL 0
 #define ST_VALUE 1
@@ -760,9 +768,9 @@ YY_DECL
 		}
 
 	{
-#line 26 "uci2.l"
+#line 34 "uci2.l"
 
-#line 765 "lexer.c"
+#line 773 "lexer.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -822,55 +830,55 @@ do_action:	/* This label is used only to access EOF actions. */
 case 1:
 /* rule 1 can match eol */
 YY_RULE_SETUP
-#line 27 "uci2.l"
+#line 35 "uci2.l"
 { BEGIN(INITIAL); }
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 28 "uci2.l"
+#line 36 "uci2.l"
 ;
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 29 "uci2.l"
+#line 37 "uci2.l"
 ;
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 30 "uci2.l"
+#line 38 "uci2.l"
 { BEGIN(ST_VALUE); return OPTION; }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 31 "uci2.l"
+#line 39 "uci2.l"
 { BEGIN(ST_VALUE); return LIST; }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 32 "uci2.l"
-{ yylval->string = uci_unquote(yytext, yyleng); return VALUE; }
+#line 40 "uci2.l"
+{ yylval->value.string = uci_unquote(yytext, yyleng, &yylval->value.hash); return VALUE; }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 33 "uci2.l"
+#line 41 "uci2.l"
 { BEGIN(ST_VALUE); return CONFIG; }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 34 "uci2.l"
+#line 42 "uci2.l"
 { BEGIN(ST_VALUE); return PACKAGE; }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 36 "uci2.l"
+#line 44 "uci2.l"
 { return 1; }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 37 "uci2.l"
+#line 45 "uci2.l"
 ECHO;
 	YY_BREAK
-#line 873 "lexer.c"
+#line 881 "lexer.c"
 case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(ST_VALUE):
 	yyterminate();
@@ -2014,33 +2022,50 @@ void yyfree (void * ptr , yyscan_t yyscanner)
 
 #define YYTABLES_NAME "yytables"
 
-#line 37 "uci2.l"
+#line 45 "uci2.l"
 
 
 // how Flex handles ambiguous patterns (config and value)
 // - match the longest possible string every time the scanner matches input
 // - in the case of a tie, use the pattern that appears first in the program
 
-// basic unquote method
-char *uci_unquote(char *string, int string_size)
+// basic unquote method, hashes the unquoted value while copying it
+char *uci_unquote(char *string, int string_size, uint64_t *hash)
 {
     char *result = NULL;
+	uint64_t result_hash = HASH_SEED;
 
 	if (string_size >= 2 && ((string[0] == '\'' && string[string_size - 1] == '\'') || (string[0] == '"' && string[string_size - 1] == '"'))) {
-		result = xcalloc((size_t) (string_size - 1), sizeof(char));
-		memcpy(result, string + 1, (size_t) (string_size - 2));
-		result[string_size - 2] = '\0';
-	} else if (string_size >= 0) {
+		string++;
+		string_size -= 2;
+	}
+
+	if (string_size >= 0) {
 		result = xcalloc((size_t) (string_size + 1), sizeof(char));
-		memcpy(result, string, (size_t) string_size);
+		for (int i = 0; i < string_size; i++) {
+			result[i] = string[i];
+			result_hash = HASH_BYTE(result_hash, string[i]);
+		}
 		result[string_size] = '\0';
 	} else {
         result = NULL;
+		result_hash = 0;
     }
 
+	*hash = result_hash;
+
 	return result;
 }
 
+// reset the scanner for a new input, the buffer is flushed but kept allocated
+void scanner_reset(yyscan_t scanner)
+{
+	struct yyguts_t *yyg = (struct yyguts_t *) scanner;
+
+	yy_flush_buffer(YY_CURRENT_BUFFER, scanner);
+	BEGIN(INITIAL);
+}
+
 // yyerror
 extern void yyerror(yyscan_t scanner, ast_t *ctx, const char *string)
 {
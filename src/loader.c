@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <assert.h>
+#include <linux/limits.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utils/debug.h"
+#include "utils/memory.h"
+
+#include "loader.h"
+
+void loader_files_read(const char **configs, size_t configs_number, const char *path_prefix, loader_callback_t callback, void *user_data)
+{
+	char path[PATH_MAX] = {0};
+	char *buffer = NULL;
+	size_t buffer_size = 0;
+	uci2_error_e error = UE_NONE;
+
+	assert(configs);
+	assert(callback);
+
+#ifdef UCI2_IO_URING
+	// submit the opens, statx calls and reads of many files at once
+	if (loader_uring_files_read(configs, configs_number, path_prefix, callback, user_data)) {
+		return;
+	}
+
+	DEBUG("io_uring not available, reading files one by one");
+#endif
+
+	for (size_t i = 0; i < configs_number; i++) {
+		loader_path_get(path, sizeof(path), path_prefix, configs[i]);
+
+		error = loader_file_read(path, &buffer, &buffer_size);
+		callback(user_data, i, buffer, buffer_size, error);
+
+		XFREE(buffer);
+		buffer_size = 0;
+	}
+}
+
+void loader_path_get(char *path, size_t path_size, const char *path_prefix, const char *config)
+{
+	assert(path);
+	assert(config);
+
+	if (config[0] == '/' || path_prefix == NULL) {
+		snprintf(path, path_size, "%s", config);
+	} else {
+		snprintf(path, path_size, "%s/%s", path_prefix, config);
+	}
+}
+
+uci2_error_e loader_file_read(const char *path, char **buffer, size_t *buffer_size)
+{
+	int error = 0;
+	uci2_error_e uci2_error = UE_NONE;
+	int file = -1;
+	struct stat stat_buffer = {0};
+	size_t offset = 0;
+	ssize_t result = 0;
+
+	assert(path);
+	assert(buffer);
+	assert(buffer_size);
+
+	*buffer = NULL;
+	*buffer_size = 0;
+
+	errno = 0;
+	file = open(path, O_RDONLY);
+	if (file < 0) {
+		DEBUG("open(%s) error(%d): %s", path, errno, strerror(errno));
+		uci2_error = (errno == ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
+		goto error_out;
+	}
+
+	errno = 0;
+	error = fstat(file, &stat_buffer);
+	if (error) {
+		DEBUG("fstat(%s) error(%d): %s", path, errno, strerror(errno));
+		uci2_error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	if (S_ISREG(stat_buffer.st_mode) == 0) {
+		DEBUG("%s is not a regular file", path);
+		uci2_error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	if (stat_buffer.st_size > 0) {
+		*buffer = xmalloc((size_t) stat_buffer.st_size);
+	}
+
+	// a file that shrank since fstat is read up to its current end
+	while (offset < (size_t) stat_buffer.st_size) {
+		errno = 0;
+		result = read(file, *buffer + offset, (size_t) stat_buffer.st_size - offset);
+		if (result < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (result < 0) {
+			DEBUG("read(%s) error(%d): %s", path, errno, strerror(errno));
+			uci2_error = UE_FILE_IO;
+			goto error_out;
+		}
+
+		if (result == 0) {
+			break;
+		}
+
+		offset += (size_t) result;
+	}
+
+	*buffer_size = offset;
+
+	goto out;
+
+error_out:
+	XFREE(*buffer);
+
+out:
+	if (file >= 0) {
+		close(file);
+	}
+
+	return uci2_error;
+}
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef LOADER_H_ONCE
+#define LOADER_H_ONCE
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "uci2.h"
+
+// maximum number of files read at the same time by the batch loader
+#define LOADER_QUEUE_DEPTH (32)
+
+// called once for every file in completion order, the buffer is released after the call returns
+typedef void (*loader_callback_t)(void *user_data, size_t index, const char *buffer, size_t buffer_size, uci2_error_e error);
+
+void loader_files_read(const char **configs, size_t configs_number, const char *path_prefix, loader_callback_t callback, void *user_data);
+void loader_path_get(char *path, size_t path_size, const char *path_prefix, const char *config);
+uci2_error_e loader_file_read(const char *path, char **buffer, size_t *buffer_size);
+
+#ifdef UCI2_IO_URING
+// returns false without calling the callback if io_uring can not be used
+bool loader_uring_files_read(const char **configs, size_t configs_number, const char *path_prefix, loader_callback_t callback, void *user_data);
+#endif
+
+#endif /* LOADER_H_ONCE */
@@ -0,0 +1,506 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+// struct statx and syscall()
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <linux/limits.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utils/debug.h"
+#include "utils/memory.h"
+
+#include "loader.h"
+
+// two requests (openat and statx) can be in flight for every file
+#define LOADER_URING_ENTRIES (LOADER_QUEUE_DEPTH * 2)
+// size of a single read request, io_uring takes 32 bit lengths
+#define LOADER_URING_READ_SIZE_MAX (1U << 30)
+
+typedef enum {
+	LOADER_OP_OPEN,
+	LOADER_OP_STATX,
+	LOADER_OP_READ,
+	LOADER_OP_NUMBER,
+} loader_op_e;
+
+typedef struct {
+	int fd;
+	unsigned sq_entries;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_ring_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_ring_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+} loader_uring_t;
+
+// a file being loaded
+typedef struct {
+	bool busy;
+	size_t index;
+	char path[PATH_MAX];
+	struct statx statx;
+	int fd;
+	unsigned pending;
+	uci2_error_e error;
+	char *buffer;
+	size_t buffer_size;
+	size_t offset;
+} loader_slot_t;
+
+static bool loader_uring_init(loader_uring_t *uring);
+static void loader_uring_destroy(loader_uring_t *uring);
+static bool loader_uring_probe(loader_uring_t *uring);
+static struct io_uring_sqe *loader_uring_sqe_get(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot, loader_op_e op);
+static int loader_uring_submit_and_wait(loader_uring_t *uring);
+static bool loader_uring_drain(loader_uring_t *uring, loader_slot_t *slots);
+static void loader_slot_start(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot, size_t index, const char *path_prefix, const char *config);
+static void loader_slot_read(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot);
+static bool loader_slot_complete(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot, loader_op_e op, int result);
+static void loader_slot_finish(loader_slot_t *slot, loader_callback_t callback, void *user_data);
+
+bool loader_uring_files_read(const char **configs, size_t configs_number, const char *path_prefix, loader_callback_t callback, void *user_data)
+{
+	loader_uring_t uring = {0};
+	loader_slot_t *slots = NULL;
+	loader_slot_t *slot = NULL;
+	size_t next = 0;
+	size_t active = 0;
+	unsigned cq_head = 0;
+	unsigned cq_tail = 0;
+	struct io_uring_cqe *cqe = NULL;
+	int error = 0;
+	bool drained = true;
+
+	assert(configs);
+	assert(callback);
+
+	if (loader_uring_init(&uring) == false) {
+		return false;
+	}
+
+	slots = xcalloc(LOADER_QUEUE_DEPTH, sizeof(loader_slot_t));
+
+	while (next < configs_number || active) {
+		// keep the queue full, every free slot takes the next file
+		for (size_t i = 0; i < LOADER_QUEUE_DEPTH && next < configs_number; i++) {
+			if (slots[i].busy == false) {
+				loader_slot_start(&uring, slots, &slots[i], next, path_prefix, configs[next]);
+				next++;
+				active++;
+			}
+		}
+
+		error = loader_uring_submit_and_wait(&uring);
+		if (error) {
+			DEBUG("io_uring_enter error(%d): %s", -error, strerror(-error));
+			break;
+		}
+
+		// files are handed over as soon as their data is in, while the other reads are still in flight
+		cq_head = *uring.cq_head;
+		cq_tail = __atomic_load_n(uring.cq_tail, __ATOMIC_ACQUIRE);
+		for (; cq_head != cq_tail; cq_head++) {
+			cqe = &uring.cqes[cq_head & *uring.cq_ring_mask];
+			slot = &slots[cqe->user_data / LOADER_OP_NUMBER];
+
+			if (loader_slot_complete(&uring, slots, slot, (loader_op_e) (cqe->user_data % LOADER_OP_NUMBER), cqe->res)) {
+				loader_slot_finish(slot, callback, user_data);
+				active--;
+			}
+		}
+		__atomic_store_n(uring.cq_head, cq_head, __ATOMIC_RELEASE);
+	}
+
+	// the ring failed, closing it does not wait for requests in flight that still write into the slots and buffers
+	if (error) {
+		drained = loader_uring_drain(&uring, slots);
+	}
+
+	loader_uring_destroy(&uring);
+
+	for (size_t i = 0; i < LOADER_QUEUE_DEPTH; i++) {
+		if (slots[i].busy) {
+			if (drained == false) {
+				slots[i].buffer = NULL;
+			}
+			slots[i].error = UE_FILE_IO;
+			loader_slot_finish(&slots[i], callback, user_data);
+		}
+	}
+
+	for (; next < configs_number; next++) {
+		callback(user_data, next, NULL, 0, UE_FILE_IO);
+	}
+
+	// leaked rather than freed under a request that may still complete
+	if (drained) {
+		XFREE(slots);
+	}
+
+	return true;
+}
+
+static bool loader_uring_init(loader_uring_t *uring)
+{
+	struct io_uring_params params = {0};
+	long fd = -1;
+
+	errno = 0;
+	fd = syscall(__NR_io_uring_setup, LOADER_URING_ENTRIES, &params);
+	if (fd < 0) {
+		DEBUG("io_uring_setup error(%d): %s", errno, strerror(errno));
+		return false;
+	}
+
+	uring->fd = (int) fd;
+	uring->sq_entries = params.sq_entries;
+	uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	// both rings share a single mapping on newer kernels
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (uring->cq_ring_size > uring->sq_ring_size) {
+			uring->sq_ring_size = uring->cq_ring_size;
+		}
+		uring->cq_ring_size = uring->sq_ring_size;
+	}
+
+	uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+	if (uring->sq_ring == MAP_FAILED) {
+		uring->sq_ring = NULL;
+		goto error_out;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		uring->cq_ring = uring->sq_ring;
+	} else {
+		uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+		if (uring->cq_ring == MAP_FAILED) {
+			uring->cq_ring = NULL;
+			goto error_out;
+		}
+	}
+
+	uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+	if (uring->sqes == MAP_FAILED) {
+		uring->sqes = NULL;
+		goto error_out;
+	}
+
+	uring->sq_head = (unsigned *) ((char *) uring->sq_ring + params.sq_off.head);
+	uring->sq_tail = (unsigned *) ((char *) uring->sq_ring + params.sq_off.tail);
+	uring->sq_ring_mask = (unsigned *) ((char *) uring->sq_ring + params.sq_off.ring_mask);
+	uring->sq_array = (unsigned *) ((char *) uring->sq_ring + params.sq_off.array);
+	uring->cq_head = (unsigned *) ((char *) uring->cq_ring + params.cq_off.head);
+	uring->cq_tail = (unsigned *) ((char *) uring->cq_ring + params.cq_off.tail);
+	uring->cq_ring_mask = (unsigned *) ((char *) uring->cq_ring + params.cq_off.ring_mask);
+	uring->cqes = (struct io_uring_cqe *) ((char *) uring->cq_ring + params.cq_off.cqes);
+
+	// openat, statx and read need Linux 5.6
+	if (loader_uring_probe(uring) == false) {
+		DEBUG("io_uring does not support the required operations");
+		goto error_out;
+	}
+
+	return true;
+
+error_out:
+	loader_uring_destroy(uring);
+
+	return false;
+}
+
+static void loader_uring_destroy(loader_uring_t *uring)
+{
+	if (uring->sqes) {
+		munmap(uring->sqes, uring->sqes_size);
+		uring->sqes = NULL;
+	}
+
+	if (uring->cq_ring && uring->cq_ring != uring->sq_ring) {
+		munmap(uring->cq_ring, uring->cq_ring_size);
+	}
+	uring->cq_ring = NULL;
+
+	if (uring->sq_ring) {
+		munmap(uring->sq_ring, uring->sq_ring_size);
+		uring->sq_ring = NULL;
+	}
+
+	if (uring->fd >= 0) {
+		close(uring->fd);
+		uring->fd = -1;
+	}
+}
+
+static bool loader_uring_probe(loader_uring_t *uring)
+{
+	struct io_uring_probe *probe = NULL;
+	const unsigned ops[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ};
+	bool supported = true;
+	long error = 0;
+
+	probe = xcalloc(1, sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op));
+
+	error = syscall(__NR_io_uring_register, uring->fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+	if (error < 0) {
+		supported = false;
+	}
+
+	for (size_t i = 0; supported && i < ARRAY_SIZE(ops); i++) {
+		if (ops[i] > probe->last_op || (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED) == 0) {
+			supported = false;
+		}
+	}
+
+	XFREE(probe);
+
+	return supported;
+}
+
+static struct io_uring_sqe *loader_uring_sqe_get(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot, loader_op_e op)
+{
+	struct io_uring_sqe *sqe = NULL;
+	unsigned tail = *uring->sq_tail;
+	unsigned index = tail & *uring->sq_ring_mask;
+
+	// a slot never has more than two requests in flight, so the ring can not overflow
+	assert(tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) < uring->sq_entries);
+
+	sqe = &uring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->user_data = (uint64_t) (slot - slots) * LOADER_OP_NUMBER + op;
+
+	uring->sq_array[index] = index;
+	__atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	return sqe;
+}
+
+static int loader_uring_submit_and_wait(loader_uring_t *uring)
+{
+	unsigned to_submit = 0;
+	long result = 0;
+
+	do {
+		to_submit = *uring->sq_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+		errno = 0;
+		result = syscall(__NR_io_uring_enter, uring->fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+	} while (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+
+	return result < 0 ? -errno : 0;
+}
+
+// waits for every submitted request to complete, returns false if the ring can not be waited on
+static bool loader_uring_drain(loader_uring_t *uring, loader_slot_t *slots)
+{
+	unsigned cq_head = 0;
+	unsigned cq_tail = 0;
+	unsigned in_flight = 0;
+	struct io_uring_cqe *cqe = NULL;
+	loader_slot_t *slot = NULL;
+	long result = 0;
+
+	for (;;) {
+		cq_head = *uring->cq_head;
+		cq_tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+		for (; cq_head != cq_tail; cq_head++) {
+			cqe = &uring->cqes[cq_head & *uring->cq_ring_mask];
+			slot = &slots[cqe->user_data / LOADER_OP_NUMBER];
+			slot->pending--;
+
+			// the file is not read any further, but a descriptor that was opened is closed
+			if (cqe->user_data % LOADER_OP_NUMBER == LOADER_OP_OPEN && cqe->res >= 0) {
+				slot->fd = cqe->res;
+			}
+		}
+		__atomic_store_n(uring->cq_head, cq_head, __ATOMIC_RELEASE);
+
+		// requests left in the submission queue never reached the kernel
+		in_flight = 0;
+		for (size_t i = 0; i < LOADER_QUEUE_DEPTH; i++) {
+			if (slots[i].busy) {
+				in_flight += slots[i].pending;
+			}
+		}
+		in_flight -= *uring->sq_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+		if (in_flight == 0) {
+			return true;
+		}
+
+		errno = 0;
+		result = syscall(__NR_io_uring_enter, uring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+		if (result < 0 && errno != EINTR) {
+			DEBUG("io_uring_enter error(%d): %s, %u requests still in flight", errno, strerror(errno), in_flight);
+			return false;
+		}
+	}
+}
+
+static void loader_slot_start(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot, size_t index, const char *path_prefix, const char *config)
+{
+	struct io_uring_sqe *sqe = NULL;
+
+	slot->busy = true;
+	slot->index = index;
+	slot->fd = -1;
+	slot->error = UE_NONE;
+	slot->buffer = NULL;
+	slot->buffer_size = 0;
+	slot->offset = 0;
+	loader_path_get(slot->path, sizeof(slot->path), path_prefix, config);
+
+	// open and statx by path are independent and run at the same time
+	sqe = loader_uring_sqe_get(uring, slots, slot, LOADER_OP_OPEN);
+	sqe->opcode = IORING_OP_OPENAT;
+	sqe->fd = AT_FDCWD;
+	sqe->addr = (uint64_t) (uintptr_t) slot->path;
+	sqe->open_flags = O_RDONLY | O_CLOEXEC;
+
+	sqe = loader_uring_sqe_get(uring, slots, slot, LOADER_OP_STATX);
+	sqe->opcode = IORING_OP_STATX;
+	sqe->fd = AT_FDCWD;
+	sqe->addr = (uint64_t) (uintptr_t) slot->path;
+	sqe->len = STATX_TYPE | STATX_SIZE;
+	sqe->off = (uint64_t) (uintptr_t) &slot->statx;
+
+	slot->pending = 2;
+}
+
+static void loader_slot_read(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot)
+{
+	struct io_uring_sqe *sqe = NULL;
+	size_t size = slot->buffer_size - slot->offset;
+
+	if (size > LOADER_URING_READ_SIZE_MAX) {
+		size = LOADER_URING_READ_SIZE_MAX;
+	}
+
+	sqe = loader_uring_sqe_get(uring, slots, slot, LOADER_OP_READ);
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = slot->fd;
+	sqe->addr = (uint64_t) (uintptr_t) (slot->buffer + slot->offset);
+	sqe->len = (uint32_t) size;
+	sqe->off = (uint64_t) slot->offset;
+
+	slot->pending = 1;
+}
+
+// returns true once the file is fully read or failed
+static bool loader_slot_complete(loader_uring_t *uring, loader_slot_t *slots, loader_slot_t *slot, loader_op_e op, int result)
+{
+	slot->pending--;
+
+	switch (op) {
+		case LOADER_OP_OPEN:
+			if (result < 0) {
+				DEBUG("openat(%s) error(%d): %s", slot->path, -result, strerror(-result));
+				slot->error = (result == -ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
+			} else {
+				slot->fd = result;
+			}
+			break;
+
+		case LOADER_OP_STATX:
+			if (result < 0) {
+				DEBUG("statx(%s) error(%d): %s", slot->path, -result, strerror(-result));
+				if (slot->error == UE_NONE) {
+					slot->error = (result == -ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
+				}
+			} else if (S_ISREG(slot->statx.stx_mode) == 0) {
+				DEBUG("%s is not a regular file", slot->path);
+				if (slot->error == UE_NONE) {
+					slot->error = UE_FILE_IO;
+				}
+			}
+			break;
+
+		case LOADER_OP_READ:
+			if (result == -EINTR || result == -EAGAIN) {
+				loader_slot_read(uring, slots, slot);
+				return false;
+			}
+
+			if (result < 0) {
+				DEBUG("read(%s) error(%d): %s", slot->path, -result, strerror(-result));
+				slot->error = UE_FILE_IO;
+				return true;
+			}
+
+			// a file that shrank since statx is read up to its current end
+			if (result == 0) {
+				slot->buffer_size = slot->offset;
+				return true;
+			}
+
+			slot->offset += (size_t) result;
+			if (slot->offset < slot->buffer_size) {
+				loader_slot_read(uring, slots, slot);
+				return false;
+			}
+			return true;
+
+		default:
+			break;
+	}
+
+	if (slot->pending) {
+		return false;
+	}
+
+	if (slot->error) {
+		return true;
+	}
+
+	// both open and statx are done, read the whole file with a single request
+	slot->buffer_size = (size_t) slot->statx.stx_size;
+	if (slot->buffer_size == 0) {
+		return true;
+	}
+
+	slot->buffer = xmalloc(slot->buffer_size);
+	loader_slot_read(uring, slots, slot);
+
+	return false;
+}
+
+static void loader_slot_finish(loader_slot_t *slot, loader_callback_t callback, void *user_data)
+{
+	if (slot->fd >= 0) {
+		close(slot->fd);
+		slot->fd = -1;
+	}
+
+	if (slot->error) {
+		callback(user_data, slot->index, NULL, 0, slot->error);
+	} else {
+		callback(user_data, slot->index, slot->buffer, slot->buffer_size, UE_NONE);
+	}
+
+	XFREE(slot->buffer);
+	slot->busy = false;
+}
@@ -72,12 +72,13 @@
 
     #include "parser.h"
     #include "lexer.h"
+    #include "scanner.h"
 
     // external functions
     extern int yylex(YYSTYPE *lvalp, yyscan_t scanner);
     extern void yyerror(yyscan_t scanner, ast_t *ast, const char *string);
 
-#line 81 "parser.c"
+#line 82 "parser.c"
 
 
 
@@ -121,14 +122,24 @@ enum yysymbol_kind_t
   YYSYMBOL_package = 10,                   /* package  */
   YYSYMBOL_lines = 11,                     /* lines  */
   YYSYMBOL_line = 12,                      /* line  */
-  YYSYMBOL_config = 13,                    /* config  */
-  YYSYMBOL_options = 14,                   /* options  */
-  YYSYMBOL_option = 15                     /* option  */
+  YYSYMBOL_config_keyword = 13,            /* config_keyword  */
+  YYSYMBOL_config = 14,                    /* config  */
+  YYSYMBOL_options = 15,                   /* options  */
+  YYSYMBOL_option = 16                     /* option  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
 
 
+/* Unqualified %code blocks.  */
+#line 15 "uci2.y"
+
+    // syntax error message buffer size
+    #define SYNTAX_ERROR_MESSAGE_SIZE (256)
+    // maximum number of expected tokens listed in the syntax error message
+    #define SYNTAX_ERROR_EXPECTED_MAX (4)
+
+#line 143 "parser.c"
 
 #ifdef short
 # undef short
@@ -449,18 +460,18 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  10
+#define YYFINAL  11
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   21
+#define YYLAST   29
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  8
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  8
+#define YYNNTS  9
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  16
+#define YYNRULES  18
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  24
+#define YYNSTATES  26
 
 /* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   262
@@ -510,8 +521,8 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    61,    61,    75,    93,    99,   105,   111,   117,   125,
-     133,   146,   161,   167,   173,   176,   179
+       0,    73,    73,    85,   101,   107,   116,   124,   127,   137,
+     143,   151,   159,   172,   187,   193,   199,   202,   205
 };
 #endif
 
@@ -523,28 +534,25 @@ static const yytype_uint8 yyrline[] =
    YYSYMBOL.  No bounds checking.  */
 static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
 
-/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
-   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
-static const char *const yytname[] =
-{
-  "\"end of file\"", "error", "\"invalid token\"", "VALUE", "CONFIG",
-  "OPTION", "LIST", "PACKAGE", "$accept", "root", "package", "lines",
-  "line", "config", "options", "option", YY_NULLPTR
-};
-
 static const char *
 yysymbol_name (yysymbol_kind_t yysymbol)
 {
-  return yytname[yysymbol];
+  static const char *const yy_sname[] =
+  {
+  "end of file", "error", "invalid token", "VALUE", "CONFIG", "OPTION",
+  "LIST", "PACKAGE", "$accept", "root", "package", "lines", "line",
+  "config_keyword", "config", "options", "option", YY_NULLPTR
+  };
+  return yy_sname[yysymbol];
 }
 #endif
 
-#define YYPACT_NINF (-10)
+#define YYPACT_NINF (-6)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF (-1)
+#define YYTABLE_NINF (-4)
 
 #define yytable_value_is_error(Yyn) \
   0
@@ -553,9 +561,9 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-       1,    -1,     9,    13,    10,    10,   -10,   -10,    -2,   -10,
-     -10,    10,   -10,     5,    12,    14,     5,   -10,     5,    15,
-      16,   -10,   -10,   -10
+      -1,    -6,    -6,    17,     2,    14,     4,    -6,    19,    -6,
+      -6,    -6,     9,    -6,    11,     6,    20,    21,     6,    -6,
+       6,    22,    23,    -6,    -6,    -6
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -563,21 +571,21 @@ static const yytype_int8 yypact[] =
    means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
-       0,     0,     0,     0,     0,     2,     5,     7,     8,     4,
-       1,     3,     6,     9,     0,     0,    10,    12,    11,     0,
-      15,    13,    14,    16
+       0,     8,     9,     0,     0,     0,     0,     5,     0,     7,
+       4,     1,     0,     6,    10,    11,     0,     0,    12,    14,
+      13,     0,    17,    15,    16,    18
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -10,   -10,   -10,    17,    -5,   -10,     3,    -9
+      -6,    -6,    -6,    24,    -5,    -6,    -6,    12,     1
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-       0,     3,     4,     5,     6,     7,    16,    17
+       0,     4,     5,     6,     7,     8,     9,    18,    19
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -585,39 +593,39 @@ static const yytype_int8 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int8 yytable[] =
 {
-      12,    13,     8,    14,    15,     1,    12,    21,     2,    21,
-      14,    15,     9,    10,     1,    19,    18,    20,    22,    23,
-       0,    11
+       1,    13,    11,     2,    -2,     1,     3,    13,     2,    -3,
+       1,    16,    17,     2,    15,     1,    16,    17,     2,    23,
+      10,    23,    14,    21,    22,    24,    25,    20,     0,    12
 };
 
 static const yytype_int8 yycheck[] =
 {
-       5,     3,     3,     5,     6,     4,    11,    16,     7,    18,
-       5,     6,     3,     0,     4,     3,    13,     3,     3,     3,
-      -1,     4
+       1,     6,     0,     4,     0,     1,     7,    12,     4,     0,
+       1,     5,     6,     4,     3,     1,     5,     6,     4,    18,
+       3,    20,     3,     3,     3,     3,     3,    15,    -1,     5
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
    state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,     4,     7,     9,    10,    11,    12,    13,     3,     3,
-       0,    11,    12,     3,     5,     6,    14,    15,    14,     3,
-       3,    15,     3,     3
+       0,     1,     4,     7,     9,    10,    11,    12,    13,    14,
+       3,     0,    11,    12,     3,     3,     5,     6,    15,    16,
+      15,     3,     3,    16,     3,     3
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,     8,     9,     9,    10,    11,    11,    12,    13,    13,
-      13,    13,    14,    14,    15,    15,    15
+       0,     8,     9,     9,    10,    11,    11,    12,    12,    13,
+      14,    14,    14,    14,    15,    15,    16,    16,    16
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
-       0,     2,     1,     2,     2,     1,     2,     1,     2,     3,
-       3,     4,     1,     2,     3,     2,     3
+       0,     2,     1,     2,     2,     1,     2,     1,     1,     1,
+       2,     3,     3,     4,     1,     2,     3,     2,     3
 };
 
 
@@ -852,226 +860,21 @@ yypcontext_expected_tokens (const yypcontext_t *yyctx,
 
 
 
-#ifndef yystrlen
-# if defined __GLIBC__ && defined _STRING_H
-#  define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
-# else
-/* Return the length of YYSTR.  */
-static YYPTRDIFF_T
-yystrlen (const char *yystr)
-{
-  YYPTRDIFF_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-# endif
-#endif
+/* The kind of the lookahead of this context.  */
+static yysymbol_kind_t
+yypcontext_token (const yypcontext_t *yyctx) YY_ATTRIBUTE_UNUSED;
 
-#ifndef yystpcpy
-# if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#  define yystpcpy stpcpy
-# else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
+static yysymbol_kind_t
+yypcontext_token (const yypcontext_t *yyctx)
 {
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
+  return yyctx->yytoken;
 }
-# endif
-#endif
 
-#ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYPTRDIFF_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYPTRDIFF_T yyn = 0;
-      char const *yyp = yystr;
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
 
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            else
-              goto append;
-
-          append:
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
 
-  if (yyres)
-    return yystpcpy (yyres, yystr) - yyres;
-  else
-    return yystrlen (yystr);
-}
-#endif
-
-
-static int
-yy_syntax_error_arguments (const yypcontext_t *yyctx,
-                           yysymbol_kind_t yyarg[], int yyargn)
-{
-  /* Actual size of YYARG. */
-  int yycount = 0;
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yyctx->yytoken != YYSYMBOL_YYEMPTY)
-    {
-      int yyn;
-      if (yyarg)
-        yyarg[yycount] = yyctx->yytoken;
-      ++yycount;
-      yyn = yypcontext_expected_tokens (yyctx,
-                                        yyarg ? yyarg + 1 : yyarg, yyargn - 1);
-      if (yyn == YYENOMEM)
-        return YYENOMEM;
-      else
-        yycount += yyn;
-    }
-  return yycount;
-}
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return -1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return YYENOMEM if the
-   required number of bytes is too large to store.  */
+/* User defined function to report a syntax error.  */
 static int
-yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
-                const yypcontext_t *yyctx)
-{
-  enum { YYARGS_MAX = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat: reported tokens (one for the "unexpected",
-     one per "expected"). */
-  yysymbol_kind_t yyarg[YYARGS_MAX];
-  /* Cumulated lengths of YYARG.  */
-  YYPTRDIFF_T yysize = 0;
-
-  /* Actual size of YYARG. */
-  int yycount = yy_syntax_error_arguments (yyctx, yyarg, YYARGS_MAX);
-  if (yycount == YYENOMEM)
-    return YYENOMEM;
-
-  switch (yycount)
-    {
-#define YYCASE_(N, S)                       \
-      case N:                               \
-        yyformat = S;                       \
-        break
-    default: /* Avoid compiler warnings. */
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-#undef YYCASE_
-    }
-
-  /* Compute error message size.  Don't count the "%s"s, but reserve
-     room for the terminator.  */
-  yysize = yystrlen (yyformat) - 2 * yycount + 1;
-  {
-    int yyi;
-    for (yyi = 0; yyi < yycount; ++yyi)
-      {
-        YYPTRDIFF_T yysize1
-          = yysize + yytnamerr (YY_NULLPTR, yytname[yyarg[yyi]]);
-        if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-          yysize = yysize1;
-        else
-          return YYENOMEM;
-      }
-  }
-
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return -1;
-    }
-
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yytname[yyarg[yyi++]]);
-          yyformat += 2;
-        }
-      else
-        {
-          ++yyp;
-          ++yyformat;
-        }
-  }
-  return 0;
-}
-
+yyreport_syntax_error (const yypcontext_t *yyctx, yyscan_t *scanner, ast_t *ast);
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
@@ -1092,9 +895,9 @@ yydestruct (const char *yymsg,
   switch (yykind)
     {
     case YYSYMBOL_VALUE: /* VALUE  */
-#line 53 "uci2.y"
-            { XFREE(((*yyvaluep).string)); }
-#line 1098 "parser.c"
+#line 65 "uci2.y"
+            { XFREE(((*yyvaluep).value).string); }
+#line 901 "parser.c"
         break;
 
       default:
@@ -1157,10 +960,7 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
      action routines.  */
   YYSTYPE yyval;
 
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1174,12 +974,12 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
 
 
 /* User initialization code.  */
-#line 35 "uci2.y"
+#line 43 "uci2.y"
 {
     ast_init(ast);
 }
 
-#line 1183 "parser.c"
+#line 983 "parser.c"
 
   goto yysetstate;
 
@@ -1380,7 +1180,7 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* root: lines  */
-#line 61 "uci2.y"
+#line 73 "uci2.y"
              {
                  (yyval.node) = ast_node_new(ast, ANT_ROOT, xstrdup(AST_NODE_ROOT_NAME), 0);
                  ast->root = (yyval.node);
@@ -1391,15 +1191,13 @@ yyreduce:
                  // use children from lines
                  ast_node_move((yyval.node)->children[0], (yyvsp[0].node));
                  // merge section type nodes with the same name into a single node
-                 ast_node_merge((yyval.node)->children[0], ANT_SECTION_TYPE);
-                 // set correct names for unnamed section nodes
-                 unnamed_section_name_set((yyval.node)->children[0]);
+                 ast_node_merge((yyval.node)->children[0]);
              }
-#line 1399 "parser.c"
+#line 1197 "parser.c"
     break;
 
   case 3: /* root: package lines  */
-#line 75 "uci2.y"
+#line 85 "uci2.y"
                         {
                             (yyval.node) = ast_node_new(ast, ANT_ROOT, xstrdup(AST_NODE_ROOT_NAME), 0);
                             ast->root = (yyval.node);
@@ -1412,159 +1210,182 @@ yyreduce:
                             // use children from lines
                             ast_node_move((yyval.node)->children[1], (yyvsp[0].node));
                             // merge section type nodes with the same name into a single node
-                            ast_node_merge((yyval.node)->children[1], ANT_SECTION_TYPE);
-                            // set correct names for unnamed section nodes
-                            unnamed_section_name_set((yyval.node)->children[1]);
+                            ast_node_merge((yyval.node)->children[1]);
                         }
-#line 1420 "parser.c"
+#line 1216 "parser.c"
     break;
 
   case 4: /* package: PACKAGE VALUE  */
-#line 93 "uci2.y"
+#line 101 "uci2.y"
                         {
-                            (yyval.node) = ast_node_new(ast, ANT_PACKAGE, xstrdup(AST_NODE_PACKAGE_NAME), (yyvsp[0].string));
+                            (yyval.node) = ast_node_new(ast, ANT_PACKAGE, xstrdup(AST_NODE_PACKAGE_NAME), (yyvsp[0].value).string);
                         }
-#line 1428 "parser.c"
+#line 1224 "parser.c"
     break;
 
   case 5: /* lines: line  */
-#line 99 "uci2.y"
+#line 107 "uci2.y"
              {
                  // Use node type ANT_SENTINEL because this node is a temporary node
                  // whose children are going to be added to the node type ANT_CONFIG in the next step.
                  (yyval.node) = ast_node_new(ast, ANT_SENTINEL, NULL, NULL);
-                 ast_node_add((yyval.node), (yyvsp[0].node));
+                 // a skipped line has no node
+                 if ((yyvsp[0].node)) {
+                     ast_node_add((yyval.node), (yyvsp[0].node));
+                 }
              }
-#line 1439 "parser.c"
+#line 1238 "parser.c"
     break;
 
   case 6: /* lines: lines line  */
-#line 105 "uci2.y"
+#line 116 "uci2.y"
                    {
-                       ast_node_add((yyvsp[-1].node), (yyvsp[0].node));
+                       if ((yyvsp[0].node)) {
+                           ast_node_add((yyvsp[-1].node), (yyvsp[0].node));
+                       }
                    }
-#line 1447 "parser.c"
+#line 1248 "parser.c"
     break;
 
   case 7: /* line: config  */
-#line 111 "uci2.y"
+#line 124 "uci2.y"
               {
                   (yyval.node) = (yyvsp[0].node);
               }
-#line 1455 "parser.c"
+#line 1256 "parser.c"
+    break;
+
+  case 8: /* line: error  */
+#line 127 "uci2.y"
+             {
+                 // the parser resynchronizes at the next config keyword, the broken section is skipped
+                 if (!((scanner_input_t *) yyget_extra(scanner))->recover) {
+                     YYABORT;
+                 }
+                 (yyval.node) = NULL;
+             }
+#line 1268 "parser.c"
     break;
 
-  case 8: /* config: CONFIG VALUE  */
-#line 117 "uci2.y"
-                      {
-                          (yyval.node) = ast_node_new(ast, ANT_SECTION_TYPE, (yyvsp[0].string), NULL);
+  case 9: /* config_keyword: CONFIG  */
+#line 137 "uci2.y"
+                        {
+                            yyerrok;
+                        }
+#line 1276 "parser.c"
+    break;
+
+  case 10: /* config: config_keyword VALUE  */
+#line 143 "uci2.y"
+                              {
+                          (yyval.node) = ast_node_new_hashed(ast, ANT_SECTION_TYPE, (yyvsp[0].value).string, (yyvsp[0].value).hash, NULL, 0);
                           // ** un-named section **
-                          // create new AST for unnamed section
+                          // create new AST for unnamed section, it has no name and is addressed by position as @type[N]
                           ast_node_t *node = NULL;
-                          node = ast_node_new(ast, ANT_SECTION_NAME, xstrdup(UNNAMED_SECTION_NAME_PLACEHOLDER), NULL);
+                          node = ast_node_new(ast, ANT_SECTION_NAME, NULL, NULL);
                           ast_node_add((yyval.node), node);
                       }
-#line 1468 "parser.c"
+#line 1289 "parser.c"
     break;
 
-  case 9: /* config: CONFIG VALUE VALUE  */
-#line 125 "uci2.y"
-                             {
-                                 (yyval.node) = ast_node_new(ast, ANT_SECTION_TYPE, (yyvsp[-1].string), NULL);
+  case 11: /* config: config_keyword VALUE VALUE  */
+#line 151 "uci2.y"
+                                     {
+                                 (yyval.node) = ast_node_new_hashed(ast, ANT_SECTION_TYPE, (yyvsp[-1].value).string, (yyvsp[-1].value).hash, NULL, 0);
                                  // ** named section **
                                  // create new AST for named section
                                  ast_node_t *node = NULL;
-                                 node = ast_node_new(ast, ANT_SECTION_NAME, (yyvsp[0].string), NULL);
+                                 node = ast_node_new_hashed(ast, ANT_SECTION_NAME, (yyvsp[0].value).string, (yyvsp[0].value).hash, NULL, 0);
                                  ast_node_add((yyval.node), node);
                              }
-#line 1481 "parser.c"
+#line 1302 "parser.c"
     break;
 
-  case 10: /* config: CONFIG VALUE options  */
-#line 133 "uci2.y"
-                               {
-                                   (yyval.node) = ast_node_new(ast, ANT_SECTION_TYPE, (yyvsp[-1].string), NULL);
+  case 12: /* config: config_keyword VALUE options  */
+#line 159 "uci2.y"
+                                       {
+                                   (yyval.node) = ast_node_new_hashed(ast, ANT_SECTION_TYPE, (yyvsp[-1].value).string, (yyvsp[-1].value).hash, NULL, 0);
                                    // ** un-named section **
-                                   // create new AST for unnamed section
+                                   // create new AST for unnamed section, it has no name and is addressed by position as @type[N]
                                    ast_node_t *node = NULL;
-                                   node = ast_node_new(ast, ANT_SECTION_NAME, xstrdup(UNNAMED_SECTION_NAME_PLACEHOLDER), NULL);
+                                   node = ast_node_new(ast, ANT_SECTION_NAME, NULL, NULL);
                                    ast_node_add((yyval.node), node);
                                    // - use children from options
                                    // - both section and type present
                                    ast_node_move((yyval.node)->children[0], (yyvsp[0].node));
                                    // merge list nodes with the same name into a single node
-                                   ast_node_merge((yyval.node)->children[0], ANT_LIST);
+                                   ast_node_merge((yyval.node)->children[0]);
                               }
-#line 1499 "parser.c"
+#line 1320 "parser.c"
     break;
 
-  case 11: /* config: CONFIG VALUE VALUE options  */
-#line 146 "uci2.y"
-                                    {
-                                        (yyval.node) = ast_node_new(ast, ANT_SECTION_TYPE, (yyvsp[-2].string), NULL);
+  case 13: /* config: config_keyword VALUE VALUE options  */
+#line 172 "uci2.y"
+                                            {
+                                        (yyval.node) = ast_node_new_hashed(ast, ANT_SECTION_TYPE, (yyvsp[-2].value).string, (yyvsp[-2].value).hash, NULL, 0);
                                         // ** named section **
                                         // create new AST for section name
                                         ast_node_t *node = NULL;
-                                        node = ast_node_new(ast, ANT_SECTION_NAME, (yyvsp[-1].string), NULL);
+                                        node = ast_node_new_hashed(ast, ANT_SECTION_NAME, (yyvsp[-1].value).string, (yyvsp[-1].value).hash, NULL, 0);
                                         ast_node_add((yyval.node), node);
                                         // - use children from options
                                         // - both section and type present
                                         ast_node_move((yyval.node)->children[0], (yyvsp[0].node));
                                         // merge list nodes with the same name into a single node
-                                        ast_node_merge((yyval.node)->children[0], ANT_LIST);
+                                        ast_node_merge((yyval.node)->children[0]);
                                     }
-#line 1517 "parser.c"
+#line 1338 "parser.c"
     break;
 
-  case 12: /* options: option  */
-#line 161 "uci2.y"
+  case 14: /* options: option  */
+#line 187 "uci2.y"
                  {
                      // Use node type ANT_SENTINEL because this node is a temporary node
                      // whose children are going to be added to the node type ANT_SECTION_NAME in the next step.
                      (yyval.node) = ast_node_new(ast, ANT_SENTINEL, NULL, NULL);
                      ast_node_add((yyval.node), (yyvsp[0].node));
                  }
-#line 1528 "parser.c"
+#line 1349 "parser.c"
     break;
 
-  case 13: /* options: options option  */
-#line 167 "uci2.y"
+  case 15: /* options: options option  */
+#line 193 "uci2.y"
                          {
                              ast_node_add((yyvsp[-1].node), (yyvsp[0].node));
                          }
-#line 1536 "parser.c"
+#line 1357 "parser.c"
     break;
 
-  case 14: /* option: OPTION VALUE VALUE  */
-#line 173 "uci2.y"
+  case 16: /* option: OPTION VALUE VALUE  */
+#line 199 "uci2.y"
                             {
-                                (yyval.node) = ast_node_new(ast, ANT_OPTION, (yyvsp[-1].string), (yyvsp[0].string));
+                                (yyval.node) = ast_node_new_hashed(ast, ANT_OPTION, (yyvsp[-1].value).string, (yyvsp[-1].value).hash, (yyvsp[0].value).string, (yyvsp[0].value).hash);
                             }
-#line 1544 "parser.c"
+#line 1365 "parser.c"
     break;
 
-  case 15: /* option: LIST VALUE  */
-#line 176 "uci2.y"
+  case 17: /* option: LIST VALUE  */
+#line 202 "uci2.y"
                      {
-                              (yyval.node) = ast_node_new(ast, ANT_LIST, (yyvsp[0].string), NULL);
+                              (yyval.node) = ast_node_new_hashed(ast, ANT_LIST, (yyvsp[0].value).string, (yyvsp[0].value).hash, NULL, 0);
                           }
-#line 1552 "parser.c"
+#line 1373 "parser.c"
     break;
 
-  case 16: /* option: LIST VALUE VALUE  */
-#line 179 "uci2.y"
+  case 18: /* option: LIST VALUE VALUE  */
+#line 205 "uci2.y"
                           {
-                              (yyval.node) = ast_node_new(ast, ANT_LIST, (yyvsp[-1].string), NULL);
+                              (yyval.node) = ast_node_new_hashed(ast, ANT_LIST, (yyvsp[-1].value).string, (yyvsp[-1].value).hash, NULL, 0);
                               // add list value as new node
                               ast_node_t *node = NULL;
-                              node = ast_node_new(ast, ANT_LIST_ITEM, (yyvsp[0].string), NULL);
+                              node = ast_node_new_hashed(ast, ANT_LIST_ITEM, (yyvsp[0].value).string, (yyvsp[0].value).hash, NULL, 0);
                               ast_node_add((yyval.node), node);
                           }
-#line 1564 "parser.c"
+#line 1385 "parser.c"
     break;
 
 
-#line 1568 "parser.c"
+#line 1389 "parser.c"
 
       default: break;
     }
@@ -1614,32 +1435,7 @@ yyerrlab:
       {
         yypcontext_t yyctx
           = {yyssp, yytoken};
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == -1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = YY_CAST (char *,
-                             YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
-            if (yymsg)
-              {
-                yysyntax_error_status
-                  = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
-                yymsgp = yymsg;
-              }
-            else
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = YYENOMEM;
-              }
-          }
-        yyerror (scanner, ast, yymsgp);
-        if (yysyntax_error_status == YYENOMEM)
+        if (yyreport_syntax_error (&yyctx, scanner, ast) == 2)
           YYNOMEM;
       }
     }
@@ -1783,10 +1579,40 @@ yyreturnlab:
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
+
   return yyresult;
 }
 
-#line 188 "uci2.y"
+#line 214 "uci2.y"
+
 
+// report a syntax error at the lookahead token
+static int yyreport_syntax_error(const yypcontext_t *context, yyscan_t *scanner, ast_t *ast)
+{
+    scanner_input_t *input = yyget_extra(scanner);
+    yysymbol_kind_t token = yypcontext_token(context);
+    yysymbol_kind_t expected[SYNTAX_ERROR_EXPECTED_MAX] = {0};
+    int expected_number = 0;
+    char message[SYNTAX_ERROR_MESSAGE_SIZE] = {0};
+    size_t message_size = 0;
+
+    (void) ast;
+
+    // same text as parse.error verbose, expected tokens are listed only if there are few of them
+    message_size += (size_t) snprintf(message, sizeof(message), "syntax error, unexpected %s", yysymbol_name(token));
+    expected_number = yypcontext_expected_tokens(context, expected, SYNTAX_ERROR_EXPECTED_MAX);
+    for (int i = 0; i < expected_number && message_size < sizeof(message); i++) {
+        message_size += (size_t) snprintf(message + message_size, sizeof(message) - message_size, "%s %s", i == 0 ? ", expecting" : " or", yysymbol_name(expected[i]));
+    }
+
+    if (!input->recover) {
+        yyerror(scanner, ast, message);
+    } else if (token == YYSYMBOL_YYEOF) {
+        // end of input has no text, it is located after the last character
+        scanner_input_diagnostic_add(input, input->line, input->column, "", message);
+    } else {
+        scanner_input_diagnostic_add(input, input->token_line, input->token_column, yyget_text(scanner), message);
+    }
+
+    return 0;
+}
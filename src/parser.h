@@ -45,7 +45,7 @@
 extern int yydebug;
 #endif
 /* "%code requires" blocks.  */
-#line 14 "uci2.y"
+#line 22 "uci2.y"
 
     #include "utils/memory.h"
 
@@ -80,12 +80,16 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 40 "uci2.y"
+#line 48 "uci2.y"
 
-    char *string;
+    // unquoted token string and its hash, computed by the lexer while copying
+    struct {
+        char *string;
+        uint64_t hash;
+    } value;
     ast_node_t *node;
 
-#line 89 "parser.h"
+#line 93 "parser.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "utils/memory.h"
+
+#include "scanner.h"
+
+static uci2_error_e scanner_input_reader_call(scanner_input_t *input, char *buffer, size_t buffer_size, size_t *bytes_read);
+
+void scanner_input_init(scanner_input_t *input, uci2_config_reader_t reader, void *user_data)
+{
+	assert(input);
+
+	input->reader = reader;
+	input->user_data = user_data;
+	input->error = UE_NONE;
+	input->eof = false;
+	input->chunk_size = 0;
+	input->chunk_offset = 0;
+	input->line = 1;
+	input->column = 1;
+	input->token_line = 1;
+	input->token_column = 1;
+}
+
+uci2_error_e scanner_input_prefetch(scanner_input_t *input)
+{
+	assert(input);
+
+	input->chunk_offset = 0;
+	input->chunk_size = 0;
+
+	return scanner_input_reader_call(input, input->chunk, sizeof(input->chunk), &input->chunk_size);
+}
+
+int scanner_input_read(scanner_input_t *input, char *buffer, size_t buffer_size)
+{
+	size_t bytes_read = 0;
+
+	assert(input);
+	assert(buffer);
+
+	// serve the read-ahead chunk first
+	if (input->chunk_offset < input->chunk_size) {
+		bytes_read = input->chunk_size - input->chunk_offset;
+		if (bytes_read > buffer_size) {
+			bytes_read = buffer_size;
+		}
+
+		memcpy(buffer, input->chunk + input->chunk_offset, bytes_read);
+		input->chunk_offset += bytes_read;
+
+		return (int) bytes_read;
+	}
+
+	if (scanner_input_reader_call(input, buffer, buffer_size, &bytes_read)) {
+		return 0;
+	}
+
+	return (int) bytes_read;
+}
+
+void scanner_input_locate(scanner_input_t *input, const char *text, size_t text_size)
+{
+	assert(input);
+	assert(text);
+
+	input->token_line = input->line;
+	input->token_column = input->column;
+
+	for (size_t i = 0; i < text_size; i++) {
+		if (text[i] == '\n') {
+			input->line++;
+			input->column = 1;
+		} else {
+			input->column++;
+		}
+	}
+}
+
+void scanner_input_diagnostic_add(scanner_input_t *input, size_t line, size_t column, const char *token, const char *message)
+{
+	uci2_diagnostic_t *diagnostic = NULL;
+
+	assert(input);
+	assert(token);
+	assert(message);
+
+	if (input->diagnostics_number == input->diagnostics_size) {
+		input->diagnostics_size = input->diagnostics_size ? input->diagnostics_size * 2 : 4;
+		input->diagnostics = xrealloc(input->diagnostics, input->diagnostics_size * sizeof(uci2_diagnostic_t));
+	}
+
+	diagnostic = &input->diagnostics[input->diagnostics_number++];
+	diagnostic->line = line;
+	diagnostic->column = column;
+	diagnostic->token = xstrdup(token);
+	diagnostic->message = xstrdup(message);
+}
+
+void scanner_input_diagnostics_clear(scanner_input_t *input)
+{
+	assert(input);
+
+	// the array itself is kept for the next parse
+	for (size_t i = 0; i < input->diagnostics_number; i++) {
+		XFREE(input->diagnostics[i].token);
+		XFREE(input->diagnostics[i].message);
+	}
+
+	input->diagnostics_number = 0;
+}
+
+static uci2_error_e scanner_input_reader_call(scanner_input_t *input, char *buffer, size_t buffer_size, size_t *bytes_read)
+{
+	uci2_error_e error = UE_NONE;
+
+	*bytes_read = 0;
+
+	// the reader is not called again once it reported the end of input or an error
+	if (input->eof || input->error) {
+		return input->error;
+	}
+
+	error = input->reader(input->user_data, buffer, buffer_size, bytes_read);
+	if (error == UE_NONE && *bytes_read > buffer_size) {
+		error = UE_INVALID_ARGUMENT;
+	}
+
+	if (error) {
+		input->error = error;
+		*bytes_read = 0;
+	} else if (*bytes_read == 0) {
+		input->eof = true;
+	}
+
+	return error;
+}
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef SCANNER_H_ONCE
+#define SCANNER_H_ONCE
+
+#include <stddef.h>
+
+#include "uci2.h"
+
+// initial size of the flex buffer, flex grows it only when a single token does not fit
+#define SCANNER_BUFFER_SIZE (4096)
+// size of the read-ahead chunk used to detect empty input
+#define SCANNER_CHUNK_SIZE (512)
+
+typedef struct scanner_input_s scanner_input_t;
+
+// input source of the scanner and per parse state shared with the parser, passed to flex as yyextra
+struct scanner_input_s {
+	uci2_config_reader_t reader;
+	void *user_data;
+	uci2_error_e error;
+	bool eof;
+	char chunk[SCANNER_CHUNK_SIZE];
+	size_t chunk_size;
+	size_t chunk_offset;
+	// position of the next input character and of the last scanned token, 1-based
+	size_t line;
+	size_t column;
+	size_t token_line;
+	size_t token_column;
+	// syntax errors are collected instead of failing the parse, kept across parses
+	bool recover;
+	uci2_diagnostic_t *diagnostics;
+	size_t diagnostics_number;
+	size_t diagnostics_size;
+};
+
+void scanner_input_init(scanner_input_t *input, uci2_config_reader_t reader, void *user_data);
+uci2_error_e scanner_input_prefetch(scanner_input_t *input);
+int scanner_input_read(scanner_input_t *input, char *buffer, size_t buffer_size);
+void scanner_input_locate(scanner_input_t *input, const char *text, size_t text_size);
+void scanner_input_diagnostic_add(scanner_input_t *input, size_t line, size_t column, const char *token, const char *message);
+void scanner_input_diagnostics_clear(scanner_input_t *input);
+
+// defined in the lexer, scanner is a yyscan_t
+void scanner_reset(void *scanner);
+
+#endif /* SCANNER_H_ONCE */
@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <stddef.h>
+#include <assert.h>
+
+#include "utils/memory.h"
+
+#include "txn.h"
+#include "index.h"
+#include "journal.h"
+
+void txn_begin(ast_t *ast)
+{
+	assert(ast);
+	assert(ast->txn == NULL);
+
+	ast->txn = xcalloc(1, sizeof(txn_t));
+}
+
+uci2_error_e txn_commit(ast_t *ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	assert(ast);
+	assert(ast->txn);
+
+	// the changes are already in place, only the log goes even if they could not be journaled
+	error = journal_flush(ast);
+	txn_destroy(ast);
+
+	return error;
+}
+
+void txn_rollback(ast_t *ast)
+{
+	txn_t *txn = NULL;
+	txn_entry_t *entry = NULL;
+
+	assert(ast);
+	assert(ast->txn);
+
+	// undoing goes through the same ast_node_* functions, which must not log it again
+	txn = ast->txn;
+	ast->txn = NULL;
+
+	for (size_t i = txn->entries_number; i > 0; i--) {
+		entry = &txn->entries[i - 1];
+
+		switch (entry->type) {
+			case TET_ADD:
+				ast_node_remove(entry->node);
+				break;
+
+			case TET_REMOVE:
+				ast_node_restore(entry->parent, entry->node, entry->position);
+				break;
+
+			case TET_NAME:
+				ast_node_name_set(entry->node, entry->string);
+				break;
+
+			case TET_VALUE:
+				ast_node_value_set(entry->node, entry->string);
+				break;
+
+			case TET_REPARENT:
+				index_section_detach(entry->node);
+				ast_node_reparent_at(entry->parent, entry->node, entry->index, entry->position);
+				index_section_attach(entry->node);
+				break;
+
+			case TET_POSITION:
+				ast_node_position_set(entry->node, entry->position);
+				break;
+		}
+	}
+
+	ast->txn = txn;
+	txn_destroy(ast);
+	journal_discard(ast);
+}
+
+void txn_record(ast_t *ast, enum txn_entry_type type, ast_node_t *node, ast_node_t *parent, size_t index, size_t position, char *string)
+{
+	txn_t *txn = NULL;
+
+	assert(ast);
+	assert(ast->txn);
+	assert(node);
+
+	txn = ast->txn;
+	if (txn->entries_number == txn->entries_size) {
+		txn->entries_size = txn->entries_size ? txn->entries_size * 2 : 16;
+		txn->entries = xrealloc(txn->entries, txn->entries_size * sizeof(txn_entry_t));
+	}
+
+	txn->entries[txn->entries_number++] = (txn_entry_t){
+		.type = type,
+		.node = node,
+		.parent = parent,
+		.index = index,
+		.position = position,
+		.string = string,
+	};
+}
+
+void txn_destroy(ast_t *ast)
+{
+	assert(ast);
+
+	if (ast->txn) {
+		for (size_t i = 0; i < ast->txn->entries_number; i++) {
+			XFREE(ast->txn->entries[i].string);
+		}
+
+		XFREE(ast->txn->entries);
+		XFREE(ast->txn);
+	}
+}
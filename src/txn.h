@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef TXN_H_ONCE
+#define TXN_H_ONCE
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ast.h"
+#include "uci2.h"
+
+typedef struct txn_entry_s txn_entry_t;
+
+// one change made to the AST, undone by its inverse
+struct txn_entry_s {
+	enum txn_entry_type {
+		TET_ADD,
+		TET_REMOVE,
+		TET_NAME,
+		TET_VALUE,
+		TET_REPARENT,
+		TET_POSITION
+	} type;
+	ast_node_t *node;
+	ast_node_t *parent; // parent before the change, TET_REMOVE and TET_REPARENT
+	size_t index;       // position in the children of the parent, TET_REPARENT
+	size_t position;    // position in the sequence of the parent, TET_REMOVE, TET_REPARENT and TET_POSITION
+	char *string;       // name or value before the change, TET_NAME and TET_VALUE
+};
+
+// undo log of an open transaction, entries are undone last to first
+struct txn_s {
+	txn_entry_t *entries;
+	size_t entries_number;
+	size_t entries_size;
+};
+
+void txn_begin(ast_t *ast);
+uci2_error_e txn_commit(ast_t *ast);
+void txn_rollback(ast_t *ast);
+void txn_record(ast_t *ast, enum txn_entry_type type, ast_node_t *node, ast_node_t *parent, size_t index, size_t position, char *string);
+void txn_destroy(ast_t *ast);
+
+#endif /* TXN_H_ONCE */
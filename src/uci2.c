@@ -6,16 +6,27 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <linux/limits.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "utils/debug.h"
 #include "utils/memory.h"
+#include "utils/hash.h"
+#include "utils/kernel.h"
+#include "utils/hash_table.h"
 
 #include "parser.h"
 #include "lexer.h"
+#include "scanner.h"
+#include "loader.h"
 #include "ast.h"
+#include "index.h"
+#include "txn.h"
+#include "journal.h"
 
 #include "uci2.h"
 
@@ -30,9 +41,58 @@ struct uci2_node_iterator_s {
 	uci2_node_t *node_start;
 	size_t offset_i;
 	size_t offset_j;
+	// sections of one type collected at creation, used when node_start is NULL
+	uci2_node_t **nodes;
+	size_t nodes_number;
 };
 
+// compiled package.section[.option] expression, the section is either named or @type[N]
+struct uci2_query_s {
+	char *section;
+	uint64_t section_hash;
+	char *type;
+	uint64_t type_hash;
+	size_t position;
+	bool from_end;
+	char *option;
+	uint64_t option_hash;
+};
+
+struct uci2_parser_s {
+	yyscan_t scanner;
+	YY_BUFFER_STATE yy_buffer;
+	scanner_input_t scanner_input;
+};
+
+// AST under construction, nodes are appended as given and merged once when finished
+struct uci2_builder_s {
+	uci2_ast_t *ast;
+	ast_node_t *section;
+	ast_node_t *list;
+};
+
+typedef struct {
+	const char *buffer;
+	size_t buffer_size;
+	size_t offset;
+} uci2_buffer_reader_t;
+
+typedef struct {
+	uci2_parser_t *parser;
+	uci2_ast_t **out;
+	uci2_error_e *out_errors;
+} uci2_batch_t;
+
+static uci2_error_e uci2_parser_run(uci2_parser_t *parser, uci2_config_reader_t reader, void *user_data, uci2_ast_t **out);
+static uci2_error_e uci2_file_reader(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read);
+static uci2_error_e uci2_buffer_reader(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read);
+static void uci2_batch_parse(void *user_data, size_t index, const char *buffer, size_t buffer_size, uci2_error_e error);
+static char uci2_value_quote_get(const char *value);
+static uci2_error_e uci2_query_selector_parse(uci2_query_t *query, const char *selector, size_t selector_size);
 static uci2_error_e uci2_node_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, uci2_node_type_e type, uci2_node_t **out);
+static uci2_error_e uci2_builder_duplicates_check(ast_node_t *config_node);
+static ast_node_t *uci2_section_type_node_get(uci2_ast_t *uci2_ast, ast_node_t *config_node, const char *type);
+static uci2_error_e uci2_node_move(uci2_node_t *node, uci2_node_t *anchor, bool after);
 
 uint32_t uci2_version_numeric(void)
 {
@@ -44,207 +104,254 @@ const char *uci2_version_string(void)
 	return XSTR(UCI2_VERSION_MAJOR) "." XSTR(UCI2_VERSION_MINOR) "." XSTR(UCI2_VERSION_PATCH);
 }
 
+const char *uci2_kernel_variant_get(void)
+{
+	return kernel_variant_name_get(kernel_variant_get());
+}
+
 uci2_error_e uci2_config_parse(const char *config, uci2_ast_t **out)
 {
-	int error = 0;
-	uci2_error_e uci2_error = UE_NONE;
-	char config_file_path[PATH_MAX] = {0};
-	struct stat stat_buffer = {0};
-	FILE *config_file = NULL;
-	long config_file_size = 0;
-	char *config_file_content = NULL;
-	size_t bytes_read = 0;
-	yyscan_t scanner = {0};
-	YY_BUFFER_STATE yy_buffer = NULL;
-	uci2_ast_t *uci2_ast = NULL;
+	uci2_error_e error = UE_NONE;
+	uci2_parser_t *parser = NULL;
 
 	if (config == NULL) {
-		uci2_error = UE_INVALID_ARGUMENT;
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
 	if (out == NULL) {
-		uci2_error = UE_INVALID_ARGUMENT;
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (config[0] == '/') {
-		snprintf(config_file_path, sizeof(config_file_path), "%s", config);
-	} else {
-		snprintf(config_file_path, sizeof(config_file_path), "%s/%s", UCI_PATH_PREFIX, config);
+	error = uci2_parser_create(&parser);
+	if (error) {
+		DEBUG("uci2_parser_create error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
 	}
 
-	errno = 0;
-	error = stat(config_file_path, &stat_buffer);
+	error = uci2_parser_parse(parser, config, out);
 	if (error) {
-		DEBUG("stat(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-		uci2_error = (errno == ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
+		DEBUG("uci2_parser_parse error (%d): %s", error, uci2_error_description_get(error));
 		goto error_out;
 	}
 
-	if (S_ISREG(stat_buffer.st_mode) == 0) {
-		DEBUG("%s is not a regular file", config_file_path);
-		uci2_error = UE_FILE_IO;
+	goto out;
+
+error_out:
+out:
+	uci2_parser_destroy(&parser);
+
+	return error;
+}
+
+uci2_error_e uci2_config_parse_reader(uci2_config_reader_t reader, void *user_data, uci2_ast_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_parser_t *parser = NULL;
+
+	if (reader == NULL) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	errno = 0;
-	config_file = fopen(config_file_path, "r");
-	if (config_file == NULL) {
-		DEBUG("fopen(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-		uci2_error = UE_FILE_IO;
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	errno = 0;
-	error = fseek(config_file, 0, SEEK_END);
-	if (error < 0) {
-		DEBUG("fseek(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-		uci2_error = UE_FILE_IO;
+	error = uci2_parser_create(&parser);
+	if (error) {
+		DEBUG("uci2_parser_create error (%d): %s", error, uci2_error_description_get(error));
 		goto error_out;
 	}
 
-	errno = 0;
-	config_file_size = ftell(config_file);
-	if (config_file_size < 0) {
-		DEBUG("ftell(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-		uci2_error = UE_FILE_IO;
+	error = uci2_parser_parse_reader(parser, reader, user_data, out);
+	if (error) {
+		DEBUG("uci2_parser_parse_reader error (%d): %s", error, uci2_error_description_get(error));
 		goto error_out;
 	}
 
-	errno = 0;
-	error = fseek(config_file, 0, SEEK_SET);
-	if (error < 0) {
-		DEBUG("fseek(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-		uci2_error = UE_FILE_IO;
+	goto out;
+
+error_out:
+out:
+	uci2_parser_destroy(&parser);
+
+	return error;
+}
+
+uci2_error_e uci2_config_parse_batch(const char **configs, size_t configs_number, uci2_ast_t **out, uci2_error_e *out_errors)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_batch_t batch = {0};
+
+	if (configs == NULL) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (config_file_size == 0) {
-		uci2_ast_create(&uci2_ast);
-	} else {
-		config_file_content = xcalloc((size_t) config_file_size + 1, 1);
-
-		errno = 0;
-		bytes_read = fread(config_file_content, 1, (size_t) config_file_size, config_file);
-		if (bytes_read != (size_t) config_file_size) {
-			DEBUG("fread(%s) error: %s", config_file_path, ferror(config_file) ? strerror(errno) : "error");
-			uci2_error = UE_FILE_IO;
-			goto error_out;
-		}
-		config_file_content[config_file_size] = '\0';
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
 
-		// setup parser
-		errno = 0;
-		error = yylex_init(&scanner);
-		if (error) {
-			DEBUG("yylex_init error (%d): %s", errno, strerror(errno));
-			uci2_error = UE_PARSER;
-			goto error_out;
-		}
+	if (out_errors == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
 
-		yy_buffer = yy_scan_string(config_file_content, scanner);
-		if (yy_buffer == NULL) {
-			DEBUG("yy_scan_string error");
-			uci2_error = UE_PARSER;
+	for (size_t i = 0; i < configs_number; i++) {
+		if (configs[i] == NULL) {
+			error = UE_INVALID_ARGUMENT;
 			goto error_out;
 		}
+	}
 
-		// create AST structure
-		uci2_ast = xcalloc(1, sizeof(uci2_ast_t));
+	for (size_t i = 0; i < configs_number; i++) {
+		out[i] = NULL;
+		out_errors[i] = UE_NONE;
+	}
 
-		// if parser error occurred
-		error = yyparse(scanner, uci2_ast);
-		if (error) {
-			DEBUG("yyparse error (%d)", error);
-			uci2_error = UE_PARSER;
-			goto error_out;
-		}
+	error = uci2_parser_create(&batch.parser);
+	if (error) {
+		DEBUG("uci2_parser_create error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
 	}
 
-	*out = uci2_ast;
+	batch.out = out;
+	batch.out_errors = out_errors;
+
+	// files are parsed in completion order while the remaining reads are in flight
+	loader_files_read(configs, configs_number, UCI_PATH_PREFIX, uci2_batch_parse, &batch);
 
 	goto out;
 
 error_out:
-	uci2_ast_destroy(&uci2_ast);
-
 out:
-	if (config_file) {
-		fclose(config_file);
+	uci2_parser_destroy(&batch.parser);
+
+	return error;
+}
+
+uci2_error_e uci2_config_parse_recover(const char *config, uci2_ast_t **out, uci2_diagnostic_t **diagnostics, size_t *diagnostics_number)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_parser_t *parser = NULL;
+
+	if (config == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
-	if (yy_buffer) {
-		yy_delete_buffer(yy_buffer, scanner);
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
-	if (scanner) {
-		yylex_destroy(scanner);
+
+	if (diagnostics == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
-	if (config_file_content) {
-		XFREE(config_file_content);
+
+	if (diagnostics_number == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
 
-	return uci2_error;
+	error = uci2_parser_create(&parser);
+	if (error) {
+		DEBUG("uci2_parser_create error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	uci2_parser_recover_set(parser, true);
+
+	error = uci2_parser_parse(parser, config, out);
+	if (error) {
+		DEBUG("uci2_parser_parse error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	// hand the collected diagnostics over to the caller
+	*diagnostics = parser->scanner_input.diagnostics;
+	*diagnostics_number = parser->scanner_input.diagnostics_number;
+	parser->scanner_input.diagnostics = NULL;
+	parser->scanner_input.diagnostics_number = 0;
+	parser->scanner_input.diagnostics_size = 0;
+
+	goto out;
+
+error_out:
+out:
+	uci2_parser_destroy(&parser);
+
+	return error;
 }
 
-uci2_error_e uci2_config_remove(const char *config)
+void uci2_diagnostics_destroy(uci2_diagnostic_t **diagnostics, size_t diagnostics_number)
+{
+	if (diagnostics && *diagnostics) {
+		for (size_t i = 0; i < diagnostics_number; i++) {
+			XFREE((*diagnostics)[i].token);
+			XFREE((*diagnostics)[i].message);
+		}
+		XFREE(*diagnostics);
+	}
+}
+
+uci2_error_e uci2_parser_create(uci2_parser_t **out)
 {
 	int error = 0;
 	uci2_error_e uci2_error = UE_NONE;
-	char config_file_path[PATH_MAX] = {0};
+	uci2_parser_t *parser = NULL;
 
-	if (config[0] == '/') {
-		snprintf(config_file_path, sizeof(config_file_path), "%s", config);
-	} else {
-		snprintf(config_file_path, sizeof(config_file_path), "%s/%s", UCI_PATH_PREFIX, config);
+	if (out == NULL) {
+		uci2_error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
 
+	parser = xcalloc(1, sizeof(uci2_parser_t));
+
+	// setup scanner, its input source lives in the parser so yyextra stays valid
 	errno = 0;
-	error = remove(config_file_path);
+	error = yylex_init_extra(&parser->scanner_input, &parser->scanner);
 	if (error) {
-		DEBUG("remove(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-		uci2_error = (errno == ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
+		DEBUG("yylex_init_extra error (%d): %s", errno, strerror(errno));
+		uci2_error = UE_PARSER;
 		goto error_out;
 	}
 
-	goto out;
-
-error_out:
-out:
-	return uci2_error;
-}
+	// flex refills this buffer from the input source and only grows it for tokens that do not fit
+	parser->yy_buffer = yy_create_buffer(NULL, SCANNER_BUFFER_SIZE, parser->scanner);
+	if (parser->yy_buffer == NULL) {
+		DEBUG("yy_create_buffer error");
+		uci2_error = UE_PARSER;
+		goto error_out;
+	}
 
-uci2_error_e uci2_ast_create(uci2_ast_t **out)
-{
-	uci2_error_e error = UE_NONE;
-	uci2_ast_t *uci2_ast = NULL;
-	uci2_node_t *node = NULL;
+	yy_switch_to_buffer(parser->yy_buffer, parser->scanner);
 
-	uci2_ast = xcalloc(1, sizeof(uci2_ast_t));
-	ast_init(uci2_ast);
+	*out = parser;
 
-	uci2_ast->root = ast_node_new(uci2_ast, ANT_ROOT, xstrdup(AST_NODE_ROOT_NAME), NULL);
-	node = ast_node_new(uci2_ast, ANT_CONFIG, xstrdup(AST_NODE_CONFIG_NAME), NULL);
-	ast_node_add(uci2_ast->root, node);
+	goto out;
 
-	*out = uci2_ast;
+error_out:
+	uci2_parser_destroy(&parser);
 
-	return error;
+out:
+	return uci2_error;
 }
 
-uci2_error_e uci2_ast_sync(uci2_ast_t *uci2_ast, const char *config)
+uci2_error_e uci2_parser_parse(uci2_parser_t *parser, const char *config, uci2_ast_t **out)
 {
 	int error = 0;
 	uci2_error_e uci2_error = UE_NONE;
-	uci2_node_t *config_node = NULL;
 	char config_file_path[PATH_MAX] = {0};
-	FILE *config_file = NULL;
-	uci2_node_t *section_type_node = NULL;
-	uci2_node_t *section_node = NULL;
-	uci2_node_t *option_node = NULL;
-	bool is_empty_list = false;
-	uci2_node_t *list_element_node = NULL;
+	int config_file = -1;
+	struct stat stat_buffer = {0};
 
-	if (uci2_ast == NULL) {
+	if (parser == NULL) {
 		uci2_error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
@@ -254,278 +361,1671 @@ uci2_error_e uci2_ast_sync(uci2_ast_t *uci2_ast, const char *config)
 		goto error_out;
 	}
 
-	if (uci2_ast->root == NULL) {
-		DEBUG("could not find root node");
-		uci2_error = UE_NODE_NOT_FOUND;
+	if (out == NULL) {
+		uci2_error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	// start from config node
-	for (size_t i = 0; i < uci2_ast->root->children_number; i++) {
-		if (uci2_ast->root->children[i] &&
-			uci2_ast->root->children[i]->parent &&
-			uci2_ast->root->children[i]->type == ANT_CONFIG) {
-			config_node = uci2_ast->root->children[i];
-			break;
-		}
+	if (config[0] == '/') {
+		snprintf(config_file_path, sizeof(config_file_path), "%s", config);
+	} else {
+		snprintf(config_file_path, sizeof(config_file_path), "%s/%s", UCI_PATH_PREFIX, config);
 	}
 
-	if (config_node == NULL) {
-		DEBUG("could not find config node");
-		uci2_error = UE_NODE_NOT_FOUND;
+	errno = 0;
+	config_file = open(config_file_path, O_RDONLY);
+	if (config_file < 0) {
+		DEBUG("open(%s) error(%d): %s", config_file_path, errno, strerror(errno));
+		uci2_error = (errno == ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
 		goto error_out;
 	}
 
-	if (config[0] == '/') {
-		snprintf(config_file_path, sizeof(config_file_path), "%s", config);
-	} else {
-		snprintf(config_file_path, sizeof(config_file_path), "%s/%s", UCI_PATH_PREFIX, config);
+	errno = 0;
+	error = fstat(config_file, &stat_buffer);
+	if (error) {
+		DEBUG("fstat(%s) error(%d): %s", config_file_path, errno, strerror(errno));
+		uci2_error = UE_FILE_IO;
+		goto error_out;
 	}
 
-	config_file = fopen(config_file_path, "w");
-	if (config_file == NULL) {
-		DEBUG("error opening file: %s", config_file_path);
+	if (S_ISREG(stat_buffer.st_mode) == 0) {
+		DEBUG("%s is not a regular file", config_file_path);
 		uci2_error = UE_FILE_IO;
 		goto error_out;
 	}
 
-	for (size_t i = 0; i < config_node->children_number; i++) {
-		section_type_node = config_node->children[i];
-		if (section_type_node->parent == NULL) { // skip deleted section type nodes
-			continue;
-		}
+	// the file is read straight into the scanner buffer, no whole-file copy is made
+	uci2_error = uci2_parser_run(parser, uci2_file_reader, &config_file, out);
+	if (uci2_error) {
+		DEBUG("uci2_parser_run(%s) error (%d): %s", config_file_path, uci2_error, uci2_error_description_get(uci2_error));
+		goto error_out;
+	}
 
-		if (section_type_node->name == NULL) { // skip section type nodes with no name
-			continue;
-		}
+	goto out;
 
-		for (size_t j = 0; j < section_type_node->children_number; j++) {
-			section_node = section_type_node->children[j];
-			if (section_node->parent == NULL) { // skip deleted section nodes
-				continue;
-			}
+error_out:
+out:
+	if (config_file >= 0) {
+		close(config_file);
+	}
 
-			if (section_node->name == NULL) { // skip section nodes with no name
-				continue;
-			}
+	return uci2_error;
+}
 
-			errno = 0;
-			error = fprintf(config_file, "config %s", section_type_node->name);
-			if (error < 0) {
-				DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-				uci2_error = UE_FILE_IO;
-				goto error_out;
-			}
+uci2_error_e uci2_parser_parse_reader(uci2_parser_t *parser, uci2_config_reader_t reader, void *user_data, uci2_ast_t **out)
+{
+	if (parser == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
 
-			if (section_node->name[0] != '@') {
-				errno = 0;
-				error = fprintf(config_file, " '%s'", section_node->name);
-				if (error < 0) {
-					DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-					uci2_error = UE_FILE_IO;
-					goto error_out;
-				}
-			}
-			errno = 0;
-			error = fprintf(config_file, "\n");
-			if (error < 0) {
-				DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-				uci2_error = UE_FILE_IO;
-				goto error_out;
+	if (reader == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	if (out == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	return uci2_parser_run(parser, reader, user_data, out);
+}
+
+uci2_error_e uci2_parser_parse_buffer(uci2_parser_t *parser, const char *buffer, size_t buffer_size, uci2_ast_t **out)
+{
+	uci2_buffer_reader_t buffer_reader = {0};
+
+	if (parser == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	if (buffer == NULL && buffer_size) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	if (out == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	buffer_reader.buffer = buffer;
+	buffer_reader.buffer_size = buffer_size;
+	buffer_reader.offset = 0;
+
+	return uci2_parser_run(parser, uci2_buffer_reader, &buffer_reader, out);
+}
+
+uci2_error_e uci2_parser_recover_set(uci2_parser_t *parser, bool recover)
+{
+	if (parser == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	parser->scanner_input.recover = recover;
+
+	return UE_NONE;
+}
+
+uci2_error_e uci2_parser_diagnostics_get(uci2_parser_t *parser, const uci2_diagnostic_t **out, size_t *out_number)
+{
+	if (parser == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	if (out == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	if (out_number == NULL) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	*out = parser->scanner_input.diagnostics;
+	*out_number = parser->scanner_input.diagnostics_number;
+
+	return UE_NONE;
+}
+
+void uci2_parser_destroy(uci2_parser_t **parser)
+{
+	if (parser && *parser) {
+		if ((*parser)->yy_buffer) {
+			yy_delete_buffer((*parser)->yy_buffer, (*parser)->scanner);
+		}
+		if ((*parser)->scanner) {
+			yylex_destroy((*parser)->scanner);
+		}
+		scanner_input_diagnostics_clear(&(*parser)->scanner_input);
+		XFREE((*parser)->scanner_input.diagnostics);
+		XFREE(*parser);
+	}
+}
+
+uci2_error_e uci2_builder_create(uci2_builder_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_builder_t *builder = NULL;
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	builder = xcalloc(1, sizeof(uci2_builder_t));
+	uci2_ast_create(&builder->ast);
+
+	*out = builder;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_builder_section_add(uci2_builder_t *builder, const char *type, const char *name)
+{
+	uci2_error_e error = UE_NONE;
+	ast_node_t *type_node = NULL;
+
+	if (builder == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (type == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// names starting with @ would read as @type[N] references
+	if (name && name[0] == '@') {
+		DEBUG("section name must not start with '@': %s", name);
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// consecutive sections of a type share a type node, the others are merged when finished
+	if (builder->section && strcmp(builder->section->parent->name, type) == 0) {
+		type_node = builder->section->parent;
+	} else {
+		type_node = ast_node_new(builder->ast, ANT_SECTION_TYPE, xstrdup(type), NULL);
+		ast_node_add(ast_config_get(builder->ast), type_node);
+	}
+
+	builder->section = ast_node_new(builder->ast, ANT_SECTION_NAME, name ? xstrdup(name) : NULL, NULL);
+	ast_node_add(type_node, builder->section);
+	builder->list = NULL;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_builder_option_add(uci2_builder_t *builder, const char *name, const char *value)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (builder == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (name == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (value == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (builder->section == NULL) {
+		DEBUG("no section added");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	ast_node_add(builder->section, ast_node_new(builder->ast, ANT_OPTION, xstrdup(name), xstrdup(value)));
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_builder_list_add(uci2_builder_t *builder, const char *name, const char *value)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (builder == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (name == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (value == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (builder->section == NULL) {
+		DEBUG("no section added");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	// consecutive elements of a list share a list node, the others are merged when finished
+	if (builder->list == NULL || strcmp(builder->list->name, name) != 0) {
+		builder->list = ast_node_new(builder->ast, ANT_LIST, xstrdup(name), NULL);
+		ast_node_add(builder->section, builder->list);
+	}
+
+	ast_node_add(builder->list, ast_node_new(builder->ast, ANT_LIST_ITEM, xstrdup(value), NULL));
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_builder_finish(uci2_builder_t *builder, uci2_ast_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_ast_t *uci2_ast = NULL;
+	ast_node_t *config_node = NULL;
+	ast_node_t *type_node = NULL;
+
+	if (builder == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// the builder starts over with an empty AST whatever the outcome
+	uci2_ast = builder->ast;
+	uci2_ast_create(&builder->ast);
+	builder->section = NULL;
+	builder->list = NULL;
+
+	// merge section type nodes and then the lists of each section, as the parser does
+	config_node = ast_config_get(uci2_ast);
+	ast_node_merge(config_node);
+
+	for (size_t i = 0; i < config_node->children_number; i++) {
+		type_node = config_node->children[i];
+		for (size_t j = 0; type_node->parent && j < type_node->children_number; j++) {
+			if (type_node->children[j]->children_number > 1) {
+				ast_node_merge(type_node->children[j]);
 			}
+		}
+	}
 
-			for (size_t k = 0; k < section_node->children_number; k++) {
-				option_node = section_node->children[k];
-				if (option_node->parent == NULL) { // skip deleted option nodes
-					continue;
+	error = uci2_builder_duplicates_check(config_node);
+	if (error) {
+		DEBUG("uci2_builder_duplicates_check error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	*out = uci2_ast;
+
+	goto out;
+
+error_out:
+	uci2_ast_destroy(&uci2_ast);
+
+out:
+	return error;
+}
+
+void uci2_builder_destroy(uci2_builder_t **builder)
+{
+	if (builder && *builder) {
+		uci2_ast_destroy(&(*builder)->ast);
+		XFREE(*builder);
+	}
+}
+
+static uci2_error_e uci2_builder_duplicates_check(ast_node_t *config_node)
+{
+	uci2_error_e error = UE_NONE;
+	hash_table_t names = {0};
+	ast_node_t *type_node = NULL;
+	ast_node_t *node = NULL;
+	ast_node_t *found = NULL;
+	size_t position = 0;
+
+	// one pass over all section names, only sections of the same type may not share a name
+	hash_table_init(&names);
+
+	for (size_t i = 0; i < config_node->children_number; i++) {
+		type_node = config_node->children[i];
+		for (size_t j = 0; type_node->parent && j < type_node->children_number; j++) {
+			node = type_node->children[j];
+			if (node->name == NULL) {
+				continue;
+			}
+
+			position = HASH_TABLE_POSITION_START;
+			while ((found = hash_table_find(&names, node->name_hash, &position))) {
+				if (found->parent == node->parent && ast_node_name_equal(found, node->name, node->name_hash)) {
+					DEBUG("section named '%s' already exists", node->name);
+					error = UE_NODE_DUPLICATE;
+					goto error_out;
 				}
+			}
 
-				if (option_node->type == ANT_OPTION) {
-					if (option_node->name == NULL || option_node->value == NULL) { // skip option nodes with no name and no value
-						continue;
-					}
+			hash_table_insert(&names, node->name_hash, node);
+		}
+	}
 
-					errno = 0;
-					error = fprintf(config_file, "\toption %s '%s'\n", option_node->name, option_node->value);
-					if (error < 0) {
-						DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-						uci2_error = UE_FILE_IO;
-						goto error_out;
-					}
-				} else if (option_node->type == ANT_LIST) {
-					if (option_node->name == NULL) { // skip list nodes with no name
-						continue;
-					}
+	goto out;
 
-					is_empty_list = true;
-					for (size_t l = 0; l < option_node->children_number; l++) {
-						list_element_node = option_node->children[l];
-						if (list_element_node->parent && list_element_node->name) {
-							is_empty_list = false;
-						}
-					}
+error_out:
+out:
+	hash_table_destroy(&names);
 
-					if (is_empty_list) {
-						errno = 0;
-						error = fprintf(config_file, "\tlist %s\n", option_node->name);
-						if (error < 0) {
-							DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-							uci2_error = UE_FILE_IO;
-							goto error_out;
-						}
-					} else {
-						for (size_t l = 0; l < option_node->children_number; l++) {
-							list_element_node = option_node->children[l];
-							if (list_element_node->parent == NULL) { // skip deleted list element nodes
-								continue;
-							}
+	return error;
+}
 
-							if (list_element_node->name == NULL) { // skip list element nodes with no name
-								continue;
-							}
+static uci2_error_e uci2_parser_run(uci2_parser_t *parser, uci2_config_reader_t reader, void *user_data, uci2_ast_t **out)
+{
+	int error = 0;
+	uci2_error_e uci2_error = UE_NONE;
+	uci2_ast_t *uci2_ast = NULL;
 
-							errno = 0;
-							error = fprintf(config_file, "\tlist %s '%s'\n", option_node->name, list_element_node->name);
-							if (error < 0) {
-								DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-								uci2_error = UE_FILE_IO;
-								goto error_out;
-							}
-						}
-					}
+	// start from a clean scanner state, the buffer allocated by the previous parse is reused
+	scanner_reset(parser->scanner);
+	scanner_input_init(&parser->scanner_input, reader, user_data);
+	scanner_input_diagnostics_clear(&parser->scanner_input);
+
+	// read ahead so that an empty input results in an empty AST
+	uci2_error = scanner_input_prefetch(&parser->scanner_input);
+	if (uci2_error) {
+		DEBUG("reader error (%d): %s", uci2_error, uci2_error_description_get(uci2_error));
+		goto error_out;
+	}
+
+	if (parser->scanner_input.chunk_size == 0) {
+		uci2_ast_create(&uci2_ast);
+	} else {
+		// create AST structure
+		uci2_ast = xcalloc(1, sizeof(uci2_ast_t));
+
+		error = yyparse(parser->scanner, uci2_ast);
+
+		// if reader error occurred the input was cut short
+		if (parser->scanner_input.error) {
+			DEBUG("reader error (%d): %s", parser->scanner_input.error, uci2_error_description_get(parser->scanner_input.error));
+			uci2_error = parser->scanner_input.error;
+			goto error_out;
+		}
+
+		// if parser error occurred, a recovering parse resynchronizes at every config line and does not fail on syntax errors
+		if (error) {
+			DEBUG("yyparse error (%d)", error);
+			uci2_error = UE_PARSER;
+			goto error_out;
+		}
+	}
+
+	*out = uci2_ast;
+
+	goto out;
+
+error_out:
+	uci2_ast_destroy(&uci2_ast);
+
+out:
+	return uci2_error;
+}
+
+static uci2_error_e uci2_file_reader(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read)
+{
+	int *config_file = user_data;
+	ssize_t result = 0;
+
+	do {
+		errno = 0;
+		result = read(*config_file, buffer, buffer_size);
+	} while (result < 0 && errno == EINTR);
+
+	if (result < 0) {
+		DEBUG("read error(%d): %s", errno, strerror(errno));
+		return UE_FILE_IO;
+	}
+
+	*bytes_read = (size_t) result;
+
+	return UE_NONE;
+}
+
+static void uci2_batch_parse(void *user_data, size_t index, const char *buffer, size_t buffer_size, uci2_error_e error)
+{
+	uci2_batch_t *batch = user_data;
+
+	if (error == UE_NONE) {
+		error = uci2_parser_parse_buffer(batch->parser, buffer, buffer_size, &batch->out[index]);
+	}
+
+	batch->out_errors[index] = error;
+}
+
+// quote character that keeps the value a single token when read back, 0 if there is none
+static char uci2_value_quote_get(const char *value)
+{
+	size_t value_size = strlen(value);
+
+	// nearly every value has none of the characters, a single scan settles it
+	if (kernel_chars_find(value, value_size, "'\"\n\t") == value_size) {
+		return '\'';
+	}
+
+	// quoted values can not span lines or contain tabs and there is no escaping
+	if (kernel_chars_find(value, value_size, "\n\t") < value_size) {
+		return 0;
+	}
+
+	if (kernel_chars_find(value, value_size, "'") == value_size) {
+		return '\'';
+	}
+
+	if (kernel_chars_find(value, value_size, "\"") == value_size) {
+		return '"';
+	}
+
+	return 0;
+}
+
+static uci2_error_e uci2_buffer_reader(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read)
+{
+	uci2_buffer_reader_t *buffer_reader = user_data;
+	size_t size = buffer_reader->buffer_size - buffer_reader->offset;
+
+	if (size > buffer_size) {
+		size = buffer_size;
+	}
+
+	if (size) {
+		memcpy(buffer, buffer_reader->buffer + buffer_reader->offset, size);
+		buffer_reader->offset += size;
+	}
+	*bytes_read = size;
+
+	return UE_NONE;
+}
+
+uci2_error_e uci2_config_remove(const char *config)
+{
+	int error = 0;
+	uci2_error_e uci2_error = UE_NONE;
+	char config_file_path[PATH_MAX] = {0};
+
+	if (config[0] == '/') {
+		snprintf(config_file_path, sizeof(config_file_path), "%s", config);
+	} else {
+		snprintf(config_file_path, sizeof(config_file_path), "%s/%s", UCI_PATH_PREFIX, config);
+	}
+
+	errno = 0;
+	error = remove(config_file_path);
+	if (error) {
+		DEBUG("remove(%s) error(%d): %s", config_file_path, errno, strerror(errno));
+		uci2_error = (errno == ENOENT) ? UE_FILE_NOT_FOUND : UE_FILE_IO;
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return uci2_error;
+}
+
+uci2_error_e uci2_ast_create(uci2_ast_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *node = NULL;
+
+	uci2_ast = xcalloc(1, sizeof(uci2_ast_t));
+	ast_init(uci2_ast);
+
+	uci2_ast->root = ast_node_new(uci2_ast, ANT_ROOT, xstrdup(AST_NODE_ROOT_NAME), NULL);
+	node = ast_node_new(uci2_ast, ANT_CONFIG, xstrdup(AST_NODE_CONFIG_NAME), NULL);
+	ast_node_add(uci2_ast->root, node);
+
+	*out = uci2_ast;
+
+	return error;
+}
+
+uci2_error_e uci2_ast_sync(uci2_ast_t *uci2_ast, const char *config)
+{
+	int error = 0;
+	uci2_error_e uci2_error = UE_NONE;
+	uci2_node_t *config_node = NULL;
+	char config_file_path[PATH_MAX] = {0};
+	char config_file_path_tmp[PATH_MAX + sizeof(".tmp")] = {0};
+	FILE *config_file = NULL;
+	uci2_node_t *section_type_node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *option_node = NULL;
+	bool is_empty_list = false;
+	uci2_node_t *list_element_node = NULL;
+	char quote = 0;
+
+	if (uci2_ast == NULL) {
+		uci2_error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (config == NULL) {
+		uci2_error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// start from config node
+	config_node = ast_config_get(uci2_ast);
+
+	if (config_node == NULL) {
+		DEBUG("could not find config node");
+		uci2_error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	if (config[0] == '/') {
+		snprintf(config_file_path, sizeof(config_file_path), "%s", config);
+	} else {
+		snprintf(config_file_path, sizeof(config_file_path), "%s/%s", UCI_PATH_PREFIX, config);
+	}
+
+	// the file is written next to the config and renamed over it, a failed write leaves the config as it was
+	snprintf(config_file_path_tmp, sizeof(config_file_path_tmp), "%s.tmp", config_file_path);
+
+	config_file = fopen(config_file_path_tmp, "w");
+	if (config_file == NULL) {
+		DEBUG("error opening file: %s", config_file_path_tmp);
+		uci2_error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < config_node->children_number; i++) {
+		section_type_node = config_node->children[i];
+		if (section_type_node->parent == NULL) { // skip deleted section type nodes
+			continue;
+		}
+
+		if (section_type_node->name == NULL) { // skip section type nodes with no name
+			continue;
+		}
+
+		ast_node_children_order(section_type_node);
+		for (size_t j = 0; j < section_type_node->children_number; j++) {
+			section_node = section_type_node->children[j];
+			if (section_node->parent == NULL) { // skip deleted section nodes
+				continue;
+			}
+
+			errno = 0;
+			error = fprintf(config_file, "config %s", section_type_node->name);
+			if (error < 0) {
+				DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+				uci2_error = UE_FILE_IO;
+				goto error_out;
+			}
+
+			if (section_node->name) { // unnamed sections are written without a name
+				quote = uci2_value_quote_get(section_node->name);
+				if (quote == 0) {
+					DEBUG("section name '%s' can not be written", section_node->name);
+					uci2_error = UE_INVALID_ARGUMENT;
+					goto error_out;
+				}
+
+				errno = 0;
+				error = fprintf(config_file, " %c%s%c", quote, section_node->name, quote);
+				if (error < 0) {
+					DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+					uci2_error = UE_FILE_IO;
+					goto error_out;
+				}
+			}
+			errno = 0;
+			error = fprintf(config_file, "\n");
+			if (error < 0) {
+				DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+				uci2_error = UE_FILE_IO;
+				goto error_out;
+			}
+
+			ast_node_children_order(section_node);
+			for (size_t k = 0; k < section_node->children_number; k++) {
+				option_node = section_node->children[k];
+				if (option_node->parent == NULL) { // skip deleted option nodes
+					continue;
+				}
+
+				if (option_node->type == ANT_OPTION) {
+					if (option_node->name == NULL || option_node->value == NULL) { // skip option nodes with no name and no value
+						continue;
+					}
+
+					quote = uci2_value_quote_get(option_node->value);
+					if (quote == 0) {
+						DEBUG("option '%s' value can not be written", option_node->name);
+						uci2_error = UE_INVALID_ARGUMENT;
+						goto error_out;
+					}
+
+					errno = 0;
+					error = fprintf(config_file, "\toption %s %c%s%c\n", option_node->name, quote, option_node->value, quote);
+					if (error < 0) {
+						DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+						uci2_error = UE_FILE_IO;
+						goto error_out;
+					}
+				} else if (option_node->type == ANT_LIST) {
+					if (option_node->name == NULL) { // skip list nodes with no name
+						continue;
+					}
+
+					ast_node_children_order(option_node);
+					is_empty_list = true;
+					for (size_t l = 0; l < option_node->children_number; l++) {
+						list_element_node = option_node->children[l];
+						if (list_element_node->parent && list_element_node->name) {
+							is_empty_list = false;
+						}
+					}
+
+					if (is_empty_list) {
+						errno = 0;
+						error = fprintf(config_file, "\tlist %s\n", option_node->name);
+						if (error < 0) {
+							DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+							uci2_error = UE_FILE_IO;
+							goto error_out;
+						}
+					} else {
+						for (size_t l = 0; l < option_node->children_number; l++) {
+							list_element_node = option_node->children[l];
+							if (list_element_node->parent == NULL) { // skip deleted list element nodes
+								continue;
+							}
+
+							if (list_element_node->name == NULL) { // skip list element nodes with no name
+								continue;
+							}
+
+							quote = uci2_value_quote_get(list_element_node->name);
+							if (quote == 0) {
+								DEBUG("list '%s' element can not be written", option_node->name);
+								uci2_error = UE_INVALID_ARGUMENT;
+								goto error_out;
+							}
+
+							errno = 0;
+							error = fprintf(config_file, "\tlist %s %c%s%c\n", option_node->name, quote, list_element_node->name, quote);
+							if (error < 0) {
+								DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+								uci2_error = UE_FILE_IO;
+								goto error_out;
+							}
+						}
+					}
+
+				} else {
+					DEBUG("unreachable");
+					abort();
+				}
+			}
+
+			errno = 0;
+			error = fprintf(config_file, "\n");
+			if (error < 0) {
+				DEBUG("fprintf(%s) error(%d): %s", config_file_path_tmp, errno, strerror(errno));
+				uci2_error = UE_FILE_IO;
+				goto error_out;
+			}
+		}
+	}
+
+	errno = 0;
+	if (fflush(config_file) != 0 || fsync(fileno(config_file)) != 0) {
+		DEBUG("error writing file %s (%d): %s", config_file_path_tmp, errno, strerror(errno));
+		uci2_error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	error = fclose(config_file);
+	config_file = NULL;
+	if (error) {
+		DEBUG("error closing file %s (%d): %s", config_file_path_tmp, errno, strerror(errno));
+		uci2_error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	if (rename(config_file_path_tmp, config_file_path) != 0) {
+		DEBUG("error renaming file: %s", config_file_path_tmp);
+		uci2_error = UE_FILE_IO;
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	if (config_file) {
+		fclose(config_file);
+	}
+
+	if (config_file_path_tmp[0]) {
+		unlink(config_file_path_tmp);
+	}
+
+out:
+	return uci2_error;
+}
+
+uci2_error_e uci2_ast_clone(uci2_ast_t *uci2_ast, uci2_ast_t **out)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	*out = ast_clone(uci2_ast);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+void uci2_ast_destroy(uci2_ast_t **uci2_ast)
+{
+	if (uci2_ast && *uci2_ast) {
+		ast_destroy(*uci2_ast);
+		*uci2_ast = NULL;
+	}
+}
+
+uci2_error_e uci2_txn_begin(uci2_ast_t *uci2_ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->txn) {
+		DEBUG("transaction already open");
+		error = UE_TRANSACTION;
+		goto error_out;
+	}
+
+	txn_begin(uci2_ast);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_txn_commit(uci2_ast_t *uci2_ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->txn == NULL) {
+		DEBUG("no transaction open");
+		error = UE_TRANSACTION;
+		goto error_out;
+	}
+
+	error = txn_commit(uci2_ast);
+	if (error) {
+		DEBUG("txn_commit error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_txn_rollback(uci2_ast_t *uci2_ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->txn == NULL) {
+		DEBUG("no transaction open");
+		error = UE_TRANSACTION;
+		goto error_out;
+	}
+
+	txn_rollback(uci2_ast);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_journal_open(uci2_ast_t *uci2_ast, const char *path)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (path == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->journal) {
+		DEBUG("journal already open");
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->txn) {
+		DEBUG("transaction open");
+		error = UE_TRANSACTION;
+		goto error_out;
+	}
+
+	error = journal_open(uci2_ast, path);
+	if (error) {
+		DEBUG("journal_open error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_journal_commit(uci2_ast_t *uci2_ast, const char *config)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (config == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->journal == NULL) {
+		DEBUG("no journal open");
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (uci2_ast->txn) {
+		DEBUG("transaction open");
+		error = UE_TRANSACTION;
+		goto error_out;
+	}
+
+	// the journal is only emptied once the package file holds its changes
+	error = uci2_ast_sync(uci2_ast, config);
+	if (error) {
+		DEBUG("uci2_ast_sync error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	error = journal_truncate(uci2_ast);
+	if (error) {
+		DEBUG("journal_truncate error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_journal_close(uci2_ast_t *uci2_ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// the journal is closed either way, the caller learns that it misses changes
+	if (uci2_ast->journal && uci2_ast->journal->failed) {
+		DEBUG("journal is missing changes");
+		error = UE_FILE_IO;
+	}
+
+	journal_destroy(uci2_ast);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_get(uci2_ast_t *uci2_ast, const char *section, const char *option, uci2_node_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_t *node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *option_node = NULL;
+	uint64_t section_hash = 0;
+	uint64_t option_hash = 0;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (section == NULL && option) {
+		DEBUG("section must not be NULL if option is specified");
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// start from config node
+	node = ast_config_get(uci2_ast);
+
+	if (node == NULL) {
+		DEBUG("could not find config node");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	if (section) {
+		section_hash = hash_string(section);
+		section_node = index_section_get(uci2_ast, section, section_hash);
+		if (section_node == NULL) {
+			DEBUG("could not find section node");
+			error = UE_NODE_NOT_FOUND;
+			goto error_out;
+		}
+
+		node = section_node;
+
+		if (option) {
+			option_hash = hash_string(option);
+			option_node = index_child_find(section_node, option, option_hash);
+			if (option_node) {
+				node = option_node;
+			} else {
+				DEBUG("could not find option or list node");
+				error = UE_NODE_NOT_FOUND;
+				goto error_out;
+			}
+		}
+	}
+
+	*out = node;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_get_many(uci2_ast_t *uci2_ast, const uci2_key_t *keys, size_t keys_number, uci2_node_t **out_nodes, uci2_error_e *out_errors)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_t *config_node = NULL;
+	uci2_node_t **section_nodes = NULL;
+	hash_table_t sections = {0};
+	const uci2_key_t *key = NULL;
+	size_t position = 0;
+	uint64_t section_hash = 0;
+	size_t j = 0;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (keys == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out_nodes == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out_errors == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	hash_table_init(&sections);
+	if (keys_number) {
+		section_nodes = xcalloc(keys_number, sizeof(uci2_node_t *));
+	}
+	config_node = ast_config_get(uci2_ast);
+
+	for (size_t i = 0; i < keys_number; i++) {
+		out_nodes[i] = NULL;
+
+		if (keys[i].section == NULL && keys[i].option) {
+			DEBUG("section must not be NULL if option is specified");
+			out_errors[i] = UE_INVALID_ARGUMENT;
+			continue;
+		}
+
+		if (config_node == NULL) {
+			DEBUG("could not find config node");
+			out_errors[i] = UE_NODE_NOT_FOUND;
+			continue;
+		}
+
+		if (keys[i].section == NULL) {
+			out_nodes[i] = config_node;
+			out_errors[i] = UE_NONE;
+			continue;
+		}
+
+		// keys of the same section share the section lookup of the first of them
+		section_hash = hash_string(keys[i].section);
+		position = HASH_TABLE_POSITION_START;
+		while ((key = hash_table_find(&sections, section_hash, &position))) {
+			if (strcmp(key->section, keys[i].section) == 0) {
+				break;
+			}
+		}
+
+		if (key) {
+			j = (size_t) (key - keys);
+			section_nodes[i] = section_nodes[j];
+		} else {
+			section_nodes[i] = index_section_get(uci2_ast, keys[i].section, section_hash);
+			hash_table_insert(&sections, section_hash, (void *) &keys[i]);
+		}
+
+		if (section_nodes[i] == NULL) {
+			DEBUG("could not find section node");
+			out_errors[i] = UE_NODE_NOT_FOUND;
+			continue;
+		}
+
+		if (keys[i].option == NULL) {
+			out_nodes[i] = section_nodes[i];
+			out_errors[i] = UE_NONE;
+			continue;
+		}
+
+		out_nodes[i] = index_child_find(section_nodes[i], keys[i].option, hash_string(keys[i].option));
+		out_errors[i] = out_nodes[i] ? UE_NONE : UE_NODE_NOT_FOUND;
+	}
+
+	goto out;
+
+error_out:
+out:
+	hash_table_destroy(&sections);
+	XFREE(section_nodes);
+
+	return error;
+}
+
+uci2_error_e uci2_query_compile(const char *expression, uci2_query_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_query_t *query = NULL;
+	const char *section = NULL;
+	const char *option = NULL;
+
+	if (expression == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// the package names the config the AST was parsed from, it is only validated
+	section = strchr(expression, '.');
+	if (section == NULL || section == expression) {
+		DEBUG("missing package in '%s'", expression);
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+	section++;
+
+	option = strchr(section, '.');
+	if (option && (option[1] == '\0' || strchr(option + 1, '.'))) {
+		DEBUG("invalid option in '%s'", expression);
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	query = xcalloc(1, sizeof(uci2_query_t));
+
+	error = uci2_query_selector_parse(query, section, option ? (size_t) (option - section) : strlen(section));
+	if (error) {
+		DEBUG("invalid section in '%s'", expression);
+		goto error_out;
+	}
+
+	if (option) {
+		query->option = xstrdup(option + 1);
+		query->option_hash = hash_string(query->option);
+	}
+
+	*out = query;
+
+	goto out;
+
+error_out:
+	uci2_query_destroy(&query);
+
+out:
+	return error;
+}
+
+uci2_error_e uci2_query_exec(uci2_ast_t *uci2_ast, const uci2_query_t *query, uci2_node_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_t *node = NULL;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (query == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (ast_config_get(uci2_ast) == NULL) {
+		DEBUG("could not find config node");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	if (query->type) {
+		node = index_section_at(uci2_ast, query->type, query->type_hash, query->position, query->from_end);
+	} else {
+		node = index_section_find(uci2_ast, query->section, query->section_hash);
+	}
+
+	if (node == NULL) {
+		DEBUG("could not find section node");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	if (query->option) {
+		node = index_child_find(node, query->option, query->option_hash);
+		if (node == NULL) {
+			DEBUG("could not find option or list node");
+			error = UE_NODE_NOT_FOUND;
+			goto error_out;
+		}
+	}
+
+	*out = node;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+void uci2_query_destroy(uci2_query_t **query)
+{
+	if (query && *query) {
+		XFREE((*query)->section);
+		XFREE((*query)->type);
+		XFREE((*query)->option);
+		XFREE(*query);
+	}
+}
+
+static uci2_error_e uci2_query_selector_parse(uci2_query_t *query, const char *selector, size_t selector_size)
+{
+	size_t type_size = 0;
+
+	if (selector_size == 0) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	if (selector[0] != '@') {
+		query->section = xstrndup(selector, selector_size);
+		query->section_hash = hash_string(query->section);
+
+		return UE_NONE;
+	}
+
+	if (index_section_selector_parse(selector, selector_size, &type_size, &query->position, &query->from_end) == false) {
+		return UE_INVALID_ARGUMENT;
+	}
+
+	query->type = xstrndup(selector + 1, type_size);
+	query->type_hash = hash_string(query->type);
+
+	return UE_NONE;
+}
+
+uci2_error_e uci2_node_section_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *type, const char *name, uci2_node_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e parent_type = UNT_ROOT;
+	uci2_node_t *type_node = NULL;
+	uci2_node_t *node = NULL;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (type == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// names starting with @ would read as @type[N] references
+	if (name && name[0] == '@') {
+		DEBUG("section name must not start with '@': %s", name);
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	error = uci2_node_type_get(parent, &parent_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	if (parent_type != UNT_ROOT) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	// the section joins the bucket of its type, nothing is merged afterwards
+	type_node = uci2_section_type_node_get(uci2_ast, parent, type);
+
+	if (name && index_type_section_find(type_node, name, hash_string(name))) {
+		DEBUG("section named '%s' already exists", name);
+		error = UE_NODE_DUPLICATE;
+		goto error_out;
+	}
+
+	journal_record_begin(uci2_ast, JO_SECTION_ADD, parent);
+
+	// add section name node into the pool
+	node = ast_node_new(uci2_ast, ANT_SECTION_NAME, NULL, NULL);
+	// add section node to its parent node which is type_node
+	ast_node_add(type_node, node);
+
+	if (name) {
+		ast_node_name_set(node, name);
+	}
+
+	journal_record_end(uci2_ast, type, name);
+
+	*out = node;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_option_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *name, const char *value, uci2_node_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_t *node = NULL;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (name == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (value == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	// the name and value set below are part of this record
+	journal_record_begin(uci2_ast, JO_OPTION_ADD, parent);
+
+	error = uci2_node_add(uci2_ast, parent, UNT_OPTION, &node);
+	if (error) {
+		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	error = uci2_node_option_name_set(node, name);
+	if (error) {
+		DEBUG("uci2_node_option_name_set error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	error = uci2_node_option_value_set(node, value);
+	if (error) {
+		DEBUG("uci2_node_option_value_set error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	journal_record_end(uci2_ast, name, value);
+
+	*out = node;
+
+	goto out;
+
+error_out:
+	uci2_node_remove(node);
+	if (uci2_ast) {
+		journal_record_cancel(uci2_ast);
+	}
+
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_list_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *name, uci2_node_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_t *node = NULL;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (name == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
 
-				} else {
-					DEBUG("unreachable");
-					abort();
-				}
-			}
+	// the name and value set below are part of this record
+	journal_record_begin(uci2_ast, JO_LIST_ADD, parent);
 
-			errno = 0;
-			error = fprintf(config_file, "\n");
-			if (error < 0) {
-				DEBUG("fprintf(%s) error(%d): %s", config_file_path, errno, strerror(errno));
-				uci2_error = UE_FILE_IO;
-				goto error_out;
-			}
-		}
+	error = uci2_node_add(uci2_ast, parent, UNT_LIST, &node);
+	if (error) {
+		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	error = uci2_node_list_name_set(node, name);
+	if (error) {
+		DEBUG("uci2_node_list_name_set error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
 	}
 
-	fflush(config_file);
-	fsync(fileno(config_file));
+	journal_record_end(uci2_ast, name, NULL);
+
+	*out = node;
 
 	goto out;
 
 error_out:
-out:
-	if (config_file) {
-		fclose(config_file);
+	uci2_node_remove(node);
+	if (uci2_ast) {
+		journal_record_cancel(uci2_ast);
 	}
 
-	return uci2_error;
-}
-
-void uci2_ast_destroy(uci2_ast_t **uci2_ast)
-{
-	if (uci2_ast && *uci2_ast) {
-		ast_destroy(*uci2_ast);
-		*uci2_ast = NULL;
-	}
+out:
+	return error;
 }
 
-uci2_error_e uci2_node_get(uci2_ast_t *uci2_ast, const char *section, const char *option, uci2_node_t **out)
+uci2_error_e uci2_node_list_element_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *value, uci2_node_t **out)
 {
 	uci2_error_e error = UE_NONE;
 	uci2_node_t *node = NULL;
-	uci2_node_t *section_node = NULL;
-	uci2_node_t *option_node = NULL;
-	uci2_node_t *list_node = NULL;
 
 	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (out == NULL) {
+	if (parent == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (section == NULL && option) {
-		DEBUG("section must not be NULL if option is specified");
+	if (value == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (uci2_ast->root == NULL) {
-		DEBUG("could not find root node");
+	if (parent->parent == NULL) {
+		DEBUG("node deleted");
 		error = UE_NODE_NOT_FOUND;
 		goto error_out;
 	}
 
-	// start from config node
-	for (size_t i = 0; i < uci2_ast->root->children_number; i++) {
-		if (uci2_ast->root->children[i] &&
-			uci2_ast->root->children[i]->parent &&
-			uci2_ast->root->children[i]->type == ANT_CONFIG) {
-			node = uci2_ast->root->children[i];
-			break;
-		}
+	// the name and value set below are part of this record
+	journal_record_begin(uci2_ast, JO_LIST_ELEMENT_ADD, parent);
+
+	error = uci2_node_add(uci2_ast, parent, UNT_LIST_ELEMENT, &node);
+	if (error) {
+		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
 	}
 
-	if (node == NULL) {
-		DEBUG("could not find config node");
-		error = UE_NODE_NOT_FOUND;
+	error = uci2_node_list_element_value_set(node, value);
+	if (error) {
+		DEBUG("uci2_node_list_element_value_set error (%d): %s", error, uci2_error_description_get(error));
 		goto error_out;
 	}
 
-	if (section) {
-		for (size_t i = 0; i < node->children_number; i++) {
-			for (size_t j = 0; j < node->children[i]->children_number; j++) {
-				if (strcmp(node->children[i]->children[j]->name, section) == 0) {
-					section_node = node->children[i]->children[j];
-					break;
-				}
-			}
-		}
+	journal_record_end(uci2_ast, value, NULL);
 
-		if (section_node == NULL || section_node->parent == NULL) {
-			DEBUG("could not find section node");
-			error = UE_NODE_NOT_FOUND;
-			goto error_out;
-		}
+	*out = node;
 
-		node = section_node;
+	goto out;
 
-		if (option) {
-			for (size_t i = 0; i < section_node->children_number; i++) {
-				if (strcmp(section_node->children[i]->name, option) == 0) {
-					if (section_node->children[i]->type == ANT_OPTION) {
-						option_node = section_node->children[i];
-						break;
+error_out:
+	uci2_node_remove(node);
+	if (uci2_ast) {
+		journal_record_cancel(uci2_ast);
+	}
 
-					} else if (section_node->children[i]->type == ANT_LIST) {
-						list_node = section_node->children[i];
-						break;
+out:
+	return error;
+}
 
-					} else {
-						DEBUG("unreachable");
-						abort();
-					}
-				}
+static uci2_error_e uci2_node_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, uci2_node_type_e type, uci2_node_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e parent_type = UNT_ROOT;
+	uci2_node_t *node = NULL;
+	enum ast_node_type node_type = ANT_ROOT;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (parent->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	// validate parent and child types
+	error = uci2_node_type_get(parent, &parent_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	switch (type) {
+		case UNT_OPTION:
+			if (parent_type != UNT_SECTION) {
+				DEBUG("node type mismatch");
+				error = UE_NODE_TYPE_MISMATCH;
+				goto error_out;
 			}
 
-			if (option_node && option_node->parent) {
-				node = option_node;
-			} else if (list_node && list_node->parent) {
-				node = list_node;
-			} else {
-				DEBUG("could not find option or list node");
-				error = UE_NODE_NOT_FOUND;
+			node_type = ANT_OPTION;
+			break;
+
+		case UNT_LIST:
+			if (parent_type != UNT_SECTION) {
+				DEBUG("node type mismatch");
+				error = UE_NODE_TYPE_MISMATCH;
 				goto error_out;
 			}
-		}
+
+			node_type = ANT_LIST;
+			break;
+
+		case UNT_LIST_ELEMENT:
+			if (parent_type != UNT_LIST) {
+				DEBUG("node type mismatch");
+				error = UE_NODE_TYPE_MISMATCH;
+				goto error_out;
+			}
+
+			node_type = ANT_LIST_ITEM;
+			break;
+
+		default:
+			DEBUG("unknown node type: %d", type);
+			error = UE_INVALID_ARGUMENT;
+			goto error_out;
 	}
 
+	// add new node into the pool
+	node = ast_node_new(uci2_ast, node_type, NULL, NULL);
+	// add new node to its parent node
+	ast_node_add(parent, node);
+
 	*out = node;
 
 	goto out;
@@ -535,22 +2035,98 @@ out:
 	return error;
 }
 
-uci2_error_e uci2_node_section_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *type, const char *name, uci2_node_t **out)
+static ast_node_t *uci2_section_type_node_get(uci2_ast_t *uci2_ast, ast_node_t *config_node, const char *type)
+{
+	ast_node_t *type_node = NULL;
+
+	type_node = index_section_type_find(uci2_ast, type, hash_string(type));
+	if (type_node) {
+		return type_node;
+	}
+
+	// add section type node into the pool
+	type_node = ast_node_new(uci2_ast, ANT_SECTION_TYPE, NULL, NULL);
+	// add type node to its parent node
+	ast_node_add(config_node, type_node);
+	ast_node_name_set(type_node, type);
+
+	return type_node;
+}
+
+void uci2_node_remove(uci2_node_t *node)
+{
+	if (node && node->parent) {
+		journal_record_begin(node->ast, JO_REMOVE, node);
+		ast_node_remove(node);
+		journal_record_end(node->ast, NULL, NULL);
+	}
+}
+
+uci2_error_e uci2_node_move_before(uci2_node_t *node, uci2_node_t *anchor)
+{
+	return uci2_node_move(node, anchor, false);
+}
+
+uci2_error_e uci2_node_move_after(uci2_node_t *node, uci2_node_t *anchor)
+{
+	return uci2_node_move(node, anchor, true);
+}
+
+uci2_error_e uci2_node_set_position(uci2_node_t *node, size_t index)
 {
 	uci2_error_e error = UE_NONE;
-	uci2_node_t *node = NULL;
+	uci2_node_type_e node_type = UNT_ROOT;
+	char position[32] = {0};
 
-	if (uci2_ast == NULL) {
+	if (node == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (parent == NULL) {
+	if (node->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	error = uci2_node_type_get(node, &node_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	if (node_type == UNT_ROOT) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	if (index >= sequence_size_get(ast_node_children_sequence_get(node->parent))) {
+		DEBUG("position %zu out of range", index);
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (type == NULL) {
+	snprintf(position, sizeof(position), "%zu", index);
+
+	journal_record_begin(node->ast, JO_POSITION_SET, node);
+	ast_node_position_set(node, index);
+	journal_record_end(node->ast, position, NULL);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_iterator_new(uci2_node_t *node, uci2_node_iterator_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e node_type = UNT_ROOT;
+	uci2_node_iterator_t *node_iterator = NULL;
+
+	if (node == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
@@ -560,63 +2136,99 @@ uci2_error_e uci2_node_section_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, co
 		goto error_out;
 	}
 
-	if (parent->parent == NULL) {
+	if (node->parent == NULL) {
 		DEBUG("node deleted");
 		error = UE_NODE_NOT_FOUND;
 		goto error_out;
 	}
 
-	error = uci2_node_add(uci2_ast, parent, UNT_SECTION, &node);
+	error = uci2_node_type_get(node, &node_type);
 	if (error) {
-		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
 		goto error_out;
 	}
 
-	error = uci2_node_section_type_set(node, type);
-	if (error) {
-		DEBUG("uci2_node_section_type_set error (%d): %s", error, uci2_error_description_get(error));
+	if (node_type != UNT_ROOT && node_type != UNT_SECTION && node_type != UNT_LIST) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	node_iterator = xcalloc(1, sizeof(uci2_node_iterator_t));
+
+	node_iterator->node_start = node;
+	node_iterator->offset_i = 0;
+	node_iterator->offset_j = 0;
+
+	*out = node_iterator;
+
+	goto out;
+
+error_out:
+	uci2_node_iterator_destroy(&node_iterator);
+
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_iterator_new_by_type(uci2_ast_t *uci2_ast, const char *type, uci2_node_iterator_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_iterator_t *node_iterator = NULL;
+	uci2_node_t *type_node = NULL;
+	sequence_t *sequence = NULL;
+	sequence_link_t *link = NULL;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (type == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (name) {
-		error = uci2_node_section_name_set(node, name);
-		if (error) {
-			DEBUG("uci2_node_section_name_set error (%d): %s", error, uci2_error_description_get(error));
-			goto error_out;
+	node_iterator = xcalloc(1, sizeof(uci2_node_iterator_t));
+
+	// an unknown type gives an empty iterator
+	type_node = index_section_type_find(uci2_ast, type, hash_string(type));
+	if (type_node) {
+		sequence = ast_node_children_sequence_get(type_node);
+		if (sequence_size_get(sequence)) {
+			node_iterator->nodes = xmalloc(sequence_size_get(sequence) * sizeof(uci2_node_t *));
+		}
+		for (link = sequence_first(sequence); link; link = sequence_next(link)) {
+			node_iterator->nodes[node_iterator->nodes_number++] = AST_NODE_FROM_LINK(link);
 		}
 	}
 
-	*out = node;
+	*out = node_iterator;
 
 	goto out;
 
 error_out:
-	uci2_node_remove(node);
+	uci2_node_iterator_destroy(&node_iterator);
 
 out:
 	return error;
 }
 
-uci2_error_e uci2_node_option_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *name, const char *value, uci2_node_t **out)
+uci2_error_e uci2_node_iterator_new_by_value(uci2_ast_t *uci2_ast, const char *value, uci2_node_iterator_t **out)
 {
 	uci2_error_e error = UE_NONE;
-	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
 
 	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (parent == NULL) {
-		error = UE_INVALID_ARGUMENT;
-		goto error_out;
-	}
-
-	if (name == NULL) {
-		error = UE_INVALID_ARGUMENT;
-		goto error_out;
-	}
-
 	if (value == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
@@ -627,57 +2239,44 @@ uci2_error_e uci2_node_option_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, con
 		goto error_out;
 	}
 
-	if (parent->parent == NULL) {
-		DEBUG("node deleted");
-		error = UE_NODE_NOT_FOUND;
-		goto error_out;
-	}
-
-	error = uci2_node_add(uci2_ast, parent, UNT_OPTION, &node);
-	if (error) {
-		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
-
-	error = uci2_node_option_name_set(node, name);
-	if (error) {
-		DEBUG("uci2_node_option_name_set error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
-
-	error = uci2_node_option_value_set(node, value);
-	if (error) {
-		DEBUG("uci2_node_option_value_set error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
+	node_iterator = xcalloc(1, sizeof(uci2_node_iterator_t));
+	node_iterator->nodes = index_values_find(uci2_ast, value, &node_iterator->nodes_number);
 
-	*out = node;
+	*out = node_iterator;
 
 	goto out;
 
 error_out:
-	uci2_node_remove(node);
+	uci2_node_iterator_destroy(&node_iterator);
 
 out:
 	return error;
 }
 
-uci2_error_e uci2_node_list_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *name, uci2_node_t **out)
+uci2_error_e uci2_value_index_enable(uci2_ast_t *uci2_ast)
 {
 	uci2_error_e error = UE_NONE;
-	uci2_node_t *node = NULL;
 
 	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (parent == NULL) {
-		error = UE_INVALID_ARGUMENT;
-		goto error_out;
-	}
+	index_values_enable(uci2_ast);
 
-	if (name == NULL) {
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_iterator_new_by_name_range(uci2_ast_t *uci2_ast, const char *from, const char *to, uci2_node_iterator_t **out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_iterator_t *node_iterator = NULL;
+
+	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
@@ -687,51 +2286,31 @@ uci2_error_e uci2_node_list_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const
 		goto error_out;
 	}
 
-	if (parent->parent == NULL) {
-		DEBUG("node deleted");
-		error = UE_NODE_NOT_FOUND;
-		goto error_out;
-	}
-
-	error = uci2_node_add(uci2_ast, parent, UNT_LIST, &node);
-	if (error) {
-		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
-
-	error = uci2_node_list_name_set(node, name);
-	if (error) {
-		DEBUG("uci2_node_list_name_set error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
+	node_iterator = xcalloc(1, sizeof(uci2_node_iterator_t));
+	node_iterator->nodes = index_sections_ordered(uci2_ast, from, to, NULL, &node_iterator->nodes_number);
 
-	*out = node;
+	*out = node_iterator;
 
 	goto out;
 
 error_out:
-	uci2_node_remove(node);
+	uci2_node_iterator_destroy(&node_iterator);
 
 out:
 	return error;
 }
 
-uci2_error_e uci2_node_list_element_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *value, uci2_node_t **out)
+uci2_error_e uci2_node_iterator_new_by_name_prefix(uci2_ast_t *uci2_ast, const char *prefix, uci2_node_iterator_t **out)
 {
 	uci2_error_e error = UE_NONE;
-	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
 
 	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (parent == NULL) {
-		error = UE_INVALID_ARGUMENT;
-		goto error_out;
-	}
-
-	if (value == NULL) {
+	if (prefix == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
@@ -741,132 +2320,107 @@ uci2_error_e uci2_node_list_element_add(uci2_ast_t *uci2_ast, uci2_node_t *paren
 		goto error_out;
 	}
 
-	if (parent->parent == NULL) {
-		DEBUG("node deleted");
-		error = UE_NODE_NOT_FOUND;
-		goto error_out;
-	}
+	node_iterator = xcalloc(1, sizeof(uci2_node_iterator_t));
+	node_iterator->nodes = index_sections_ordered(uci2_ast, NULL, NULL, prefix, &node_iterator->nodes_number);
 
-	error = uci2_node_add(uci2_ast, parent, UNT_LIST_ELEMENT, &node);
-	if (error) {
-		DEBUG("uci2_node_add error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
+	*out = node_iterator;
 
-	error = uci2_node_list_element_value_set(node, value);
-	if (error) {
-		DEBUG("uci2_node_list_element_value_set error (%d): %s", error, uci2_error_description_get(error));
+	goto out;
+
+error_out:
+	uci2_node_iterator_destroy(&node_iterator);
+
+out:
+	return error;
+}
+
+uci2_error_e uci2_section_name_index_enable(uci2_ast_t *uci2_ast)
+{
+	uci2_error_e error = UE_NONE;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	*out = node;
+	index_names_enable(uci2_ast);
 
 	goto out;
 
 error_out:
-	uci2_node_remove(node);
-
 out:
 	return error;
 }
 
-static uci2_error_e uci2_node_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, uci2_node_type_e type, uci2_node_t **out)
+uci2_error_e uci2_search(uci2_ast_t *uci2_ast, const char *substring, uci2_search_callback_t callback, void *user_data)
 {
 	uci2_error_e error = UE_NONE;
-	uci2_node_type_e parent_type = UNT_ROOT;
-	uci2_node_t *type_node = NULL;
-	uci2_node_t *node = NULL;
-	enum ast_node_type node_type = ANT_ROOT;
+	ast_node_t **nodes = NULL;
+	size_t nodes_number = 0;
 
 	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (parent == NULL) {
+	if (substring == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (out == NULL) {
+	if (callback == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (parent->parent == NULL) {
-		DEBUG("node deleted");
-		error = UE_NODE_NOT_FOUND;
-		goto error_out;
+	// all matches are collected first so the callback may change the tree
+	nodes = index_search(uci2_ast, substring, &nodes_number);
+	for (size_t i = 0; i < nodes_number; i++) {
+		callback(user_data, nodes[i]);
 	}
 
-	// validate parent and child types
-	error = uci2_node_type_get(parent, &parent_type);
-	if (error) {
-		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
-	}
+	goto out;
 
-	if (type == UNT_SECTION) {
-		if (parent_type != UNT_ROOT) {
-			DEBUG("node type mismatch");
-			error = UE_NODE_TYPE_MISMATCH;
-			goto error_out;
-		}
+error_out:
+out:
+	XFREE(nodes);
 
-		// add section type node into the pool
-		type_node = ast_node_new(uci2_ast, ANT_SECTION_TYPE, NULL, NULL);
-		// add type node to its parent node
-		ast_node_add(parent, type_node);
+	return error;
+}
 
-		// add section name node into the pool
-		node = ast_node_new(uci2_ast, ANT_SECTION_NAME, NULL, NULL);
-		// add section node to its parent node which is type_node
-		ast_node_add(type_node, node);
-	} else {
-		switch (type) {
-			case UNT_OPTION:
-				if (parent_type != UNT_SECTION) {
-					DEBUG("node type mismatch");
-					error = UE_NODE_TYPE_MISMATCH;
-					goto error_out;
-				}
+uci2_error_e uci2_search_index_enable(uci2_ast_t *uci2_ast)
+{
+	uci2_error_e error = UE_NONE;
 
-				node_type = ANT_OPTION;
-				break;
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
 
-			case UNT_LIST:
-				if (parent_type != UNT_SECTION) {
-					DEBUG("node type mismatch");
-					error = UE_NODE_TYPE_MISMATCH;
-					goto error_out;
-				}
+	index_trigrams_enable(uci2_ast);
 
-				node_type = ANT_LIST;
-				break;
+	goto out;
 
-			case UNT_LIST_ELEMENT:
-				if (parent_type != UNT_LIST) {
-					DEBUG("node type mismatch");
-					error = UE_NODE_TYPE_MISMATCH;
-					goto error_out;
-				}
+error_out:
+out:
+	return error;
+}
 
-				node_type = ANT_LIST_ITEM;
-				break;
+uci2_error_e uci2_index_memory_get(uci2_ast_t *uci2_ast, size_t *out)
+{
+	uci2_error_e error = UE_NONE;
 
-			default:
-				DEBUG("unknown node type: %d", type);
-				error = UE_INVALID_ARGUMENT;
-				goto error_out;
-		}
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
 
-		// add new node into the pool
-		node = ast_node_new(uci2_ast, node_type, NULL, NULL);
-		// add new node to its parent node
-		ast_node_add(parent, node);
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
 
-	*out = node;
+	*out = index_memory_get(uci2_ast);
 
 	goto out;
 
@@ -875,52 +2429,41 @@ out:
 	return error;
 }
 
-void uci2_node_remove(uci2_node_t *node)
-{
-	if (node) {
-		node->parent = NULL;
-	}
-}
-
-uci2_error_e uci2_node_iterator_new(uci2_node_t *node, uci2_node_iterator_t **out)
+uci2_error_e uci2_section_select(uci2_ast_t *uci2_ast, const char *type, const uci2_predicate_t *predicates, size_t predicates_number, uci2_node_iterator_t **out)
 {
 	uci2_error_e error = UE_NONE;
-	uci2_node_type_e node_type = UNT_ROOT;
 	uci2_node_iterator_t *node_iterator = NULL;
 
-	if (node == NULL) {
+	if (uci2_ast == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (out == NULL) {
+	if (type == NULL) {
 		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	if (node->parent == NULL) {
-		DEBUG("node deleted");
-		error = UE_NODE_NOT_FOUND;
+	if (predicates == NULL && predicates_number) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
-	error = uci2_node_type_get(node, &node_type);
-	if (error) {
-		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
-		goto error_out;
+	for (size_t i = 0; i < predicates_number; i++) {
+		if (predicates[i].option == NULL || predicates[i].value == NULL) {
+			error = UE_INVALID_ARGUMENT;
+			goto error_out;
+		}
 	}
 
-	if (node_type != UNT_ROOT && node_type != UNT_SECTION && node_type != UNT_LIST) {
-		DEBUG("node type mismatch");
-		error = UE_NODE_TYPE_MISMATCH;
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
 		goto error_out;
 	}
 
+	// the equality indexes give the matching sections in time proportional to the result
 	node_iterator = xcalloc(1, sizeof(uci2_node_iterator_t));
-
-	node_iterator->node_start = node;
-	node_iterator->offset_i = 0;
-	node_iterator->offset_j = 0;
+	node_iterator->nodes = index_sections_select(uci2_ast, type, predicates, predicates_number, &node_iterator->nodes_number);
 
 	*out = node_iterator;
 
@@ -936,6 +2479,7 @@ out:
 void uci2_node_iterator_destroy(uci2_node_iterator_t **node_iterator)
 {
 	if (node_iterator && *node_iterator) {
+		XFREE((*node_iterator)->nodes);
 		free(*node_iterator);
 		*node_iterator = NULL;
 	}
@@ -957,6 +2501,24 @@ uci2_error_e uci2_node_iterator_next(uci2_node_iterator_t *node_iterator, uci2_n
 		goto error_out;
 	}
 
+	if (node_iterator->node_start == NULL) {
+		// sections removed after the iterator was created are skipped
+		do {
+			if (node_iterator->offset_i >= node_iterator->nodes_number) {
+				DEBUG("iterator end");
+				node = NULL;
+				error = UE_ITERATOR_END;
+				goto error_out;
+			}
+
+			node = node_iterator->nodes[node_iterator->offset_i++];
+		} while (node->parent == NULL);
+
+		*out = node;
+
+		goto out;
+	}
+
 	error = uci2_node_type_get(node_iterator->node_start, &node_type);
 	if (error) {
 		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
@@ -964,12 +2526,14 @@ uci2_error_e uci2_node_iterator_next(uci2_node_iterator_t *node_iterator, uci2_n
 	}
 
 	if (node_type == UNT_ROOT) {
-		while (node_iterator->offset_i < node_iterator->node_start->children_number &&
-			   node_iterator->node_start->children[node_iterator->offset_i]->children_number == 0) {
-			node_iterator->offset_i++;
-			node_iterator->offset_j = 0;
-		}
 		do {
+			// skip section types without further children, merged ones have none
+			while (node_iterator->offset_i < node_iterator->node_start->children_number &&
+				   node_iterator->offset_j >= node_iterator->node_start->children[node_iterator->offset_i]->children_number) {
+				node_iterator->offset_i++;
+				node_iterator->offset_j = 0;
+			}
+
 			if (node_iterator->offset_i >= node_iterator->node_start->children_number) {
 				DEBUG("iterator end");
 				node = NULL;
@@ -977,14 +2541,12 @@ uci2_error_e uci2_node_iterator_next(uci2_node_iterator_t *node_iterator, uci2_n
 				goto error_out;
 			}
 
+			// sections moved since the last call are walked in their new order
+			ast_node_children_order(node_iterator->node_start->children[node_iterator->offset_i]);
 			node = node_iterator->node_start->children[node_iterator->offset_i]->children[node_iterator->offset_j++];
-
-			if (node_iterator->offset_j >= node_iterator->node_start->children[node_iterator->offset_i]->children_number) {
-				node_iterator->offset_i++;
-				node_iterator->offset_j = 0;
-			}
 		} while (node->parent == NULL);
 	} else {
+		ast_node_children_order(node_iterator->node_start);
 		do {
 			if (node_iterator->offset_i >= node_iterator->node_start->children_number) {
 				DEBUG("iterator end");
@@ -993,16 +2555,47 @@ uci2_error_e uci2_node_iterator_next(uci2_node_iterator_t *node_iterator, uci2_n
 				goto error_out;
 			}
 
-			node = node_iterator->node_start->children[node_iterator->offset_i++];
-		} while (node->parent == NULL);
+			node = node_iterator->node_start->children[node_iterator->offset_i++];
+		} while (node->parent == NULL);
+	}
+
+	*out = node;
+
+	goto out;
+
+error_out:
+
+out:
+	return error;
+}
+
+uci2_error_e uci2_section_count(uci2_ast_t *uci2_ast, const char *type, size_t *out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_t *type_node = NULL;
+
+	if (uci2_ast == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
 	}
 
-	*out = node;
+	if (type == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	// the sequence of live sections keeps its size up to date on add and remove
+	type_node = index_section_type_find(uci2_ast, type, hash_string(type));
+	*out = type_node ? sequence_size_get(ast_node_children_sequence_get(type_node)) : 0;
 
 	goto out;
 
 error_out:
-
 out:
 	return error;
 }
@@ -1115,6 +2708,7 @@ uci2_error_e uci2_node_section_type_set(uci2_node_t *node, const char *type)
 {
 	uci2_error_e error = UE_NONE;
 	uci2_node_type_e node_type = UNT_ROOT;
+	ast_node_t *type_node = NULL;
 
 	if (node == NULL) {
 		error = UE_INVALID_ARGUMENT;
@@ -1144,19 +2738,35 @@ uci2_error_e uci2_node_section_type_set(uci2_node_t *node, const char *type)
 		goto error_out;
 	}
 
-	XFREE(node->parent->name);
-	node->parent->name = xstrdup(type);
+	if (node->parent->name && strcmp(node->parent->name, type) == 0) {
+		goto out;
+	}
+
+	type_node = index_section_type_find(node->ast, type, hash_string(type));
+	if (type_node && node->name && index_type_section_find(type_node, node->name, node->name_hash)) {
+		DEBUG("section named '%s' already exists", node->name);
+		error = UE_NODE_DUPLICATE;
+		goto error_out;
+	}
+
+	journal_record_begin(node->ast, JO_TYPE_SET, node);
 
-	// merge section type nodes with the same name into a single node
-	ast_node_merge(node->parent->parent, ANT_SECTION_TYPE);
+	if (type_node == NULL && sequence_size_get(ast_node_children_sequence_get(node->parent)) == 1) {
+		// the only section of its type takes the bucket along
+		ast_node_name_set(node->parent, type);
+	} else {
+		// only this section changes its type, the other sections stay in the old bucket
+		if (type_node == NULL) {
+			type_node = uci2_section_type_node_get(node->ast, node->parent->parent, type);
+		}
 
-	// set correct names for unnamed section nodes
-	if (node->name == NULL || node->name[0] == '@') {
-		XFREE(node->name);
-		node->name = xstrdup(UNNAMED_SECTION_NAME_PLACEHOLDER);
-		unnamed_section_name_set(node->parent->parent);
+		index_section_detach(node);
+		ast_node_reparent(type_node, node);
+		index_section_attach(node);
 	}
 
+	journal_record_end(node->ast, type, NULL);
+
 	goto out;
 
 error_out:
@@ -1185,12 +2795,50 @@ uci2_error_e uci2_node_section_name_get(uci2_node_t *node, const char **name)
 		goto error_out;
 	}
 
+	error = uci2_node_type_get(node, &node_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	if (node_type != UNT_SECTION) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	// unnamed sections have no name of their own, see uci2_node_section_name_format()
 	if (node->name == NULL) {
 		DEBUG("node attribute missing");
 		error = UE_NODE_ATTRIBUTE_MISSING;
 		goto error_out;
 	}
 
+	*name = node->name;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_section_name_format(uci2_node_t *node, char *buffer, size_t buffer_size)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e node_type = UNT_ROOT;
+	size_t name_size = 0;
+
+	if (node == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (buffer == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
 	error = uci2_node_type_get(node, &node_type);
 	if (error) {
 		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
@@ -1203,7 +2851,18 @@ uci2_error_e uci2_node_section_name_get(uci2_node_t *node, const char **name)
 		goto error_out;
 	}
 
-	*name = node->name;
+	// unnamed sections are named @type[N] after their current position
+	if (node->name) {
+		name_size = (size_t) snprintf(buffer, buffer_size, "%s", node->name);
+	} else {
+		name_size = unnamed_section_name_get(node, buffer, buffer_size);
+	}
+
+	if (name_size >= buffer_size) {
+		DEBUG("buffer too small for section name");
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
 
 	goto out;
 
@@ -1216,6 +2875,7 @@ uci2_error_e uci2_node_section_name_set(uci2_node_t *node, const char *name)
 {
 	uci2_error_e error = UE_NONE;
 	uci2_node_type_e node_type = UNT_ROOT;
+	uint64_t name_hash = 0;
 
 	if (node == NULL) {
 		error = UE_INVALID_ARGUMENT;
@@ -1227,6 +2887,13 @@ uci2_error_e uci2_node_section_name_set(uci2_node_t *node, const char *name)
 		goto error_out;
 	}
 
+	// names starting with @ would read as @type[N] references
+	if (name[0] == '@') {
+		DEBUG("section name must not start with '@': %s", name);
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
 	if (node->parent == NULL) {
 		DEBUG("node deleted");
 		error = UE_NODE_NOT_FOUND;
@@ -1245,19 +2912,16 @@ uci2_error_e uci2_node_section_name_set(uci2_node_t *node, const char *name)
 		goto error_out;
 	}
 
-	for (size_t i = 0; i < node->parent->children_number; i++) {
-		if (node->parent->children[i] &&
-			node->parent->children[i]->parent &&
-			node->parent->children[i]->name &&
-			strcmp(node->parent->children[i]->name, name) == 0) {
-			DEBUG("section named '%s' already exists", node->parent->children[i]->name);
-			error = UE_NODE_DUPLICATE;
-			goto error_out;
-		}
+	name_hash = hash_string(name);
+	if (index_type_section_find(node->parent, name, name_hash)) {
+		DEBUG("section named '%s' already exists", name);
+		error = UE_NODE_DUPLICATE;
+		goto error_out;
 	}
 
-	XFREE(node->name);
-	node->name = xstrdup(name);
+	journal_record_begin(node->ast, JO_NAME_SET, node);
+	ast_node_name_set(node, name);
+	journal_record_end(node->ast, name, NULL);
 
 	goto out;
 
@@ -1318,6 +2982,7 @@ uci2_error_e uci2_node_option_name_set(uci2_node_t *node, const char *name)
 {
 	uci2_error_e error = UE_NONE;
 	uci2_node_type_e node_type = UNT_ROOT;
+	uint64_t name_hash = 0;
 
 	if (node == NULL) {
 		error = UE_INVALID_ARGUMENT;
@@ -1347,19 +3012,16 @@ uci2_error_e uci2_node_option_name_set(uci2_node_t *node, const char *name)
 		goto error_out;
 	}
 
-	for (size_t i = 0; i < node->parent->children_number; i++) {
-		if (node->parent->children[i] &&
-			node->parent->children[i]->parent &&
-			node->parent->children[i]->name &&
-			strcmp(node->parent->children[i]->name, name) == 0) {
-			DEBUG("option named '%s' already exists", node->parent->children[i]->name);
-			error = UE_NODE_DUPLICATE;
-			goto error_out;
-		}
+	name_hash = hash_string(name);
+	if (index_child_find(node->parent, name, name_hash)) {
+		DEBUG("option named '%s' already exists", name);
+		error = UE_NODE_DUPLICATE;
+		goto error_out;
 	}
 
-	XFREE(node->name);
-	node->name = xstrdup(name);
+	journal_record_begin(node->ast, JO_NAME_SET, node);
+	ast_node_name_set(node, name);
+	journal_record_end(node->ast, name, NULL);
 
 	goto out;
 
@@ -1449,8 +3111,9 @@ uci2_error_e uci2_node_option_value_set(uci2_node_t *node, const char *value)
 		goto error_out;
 	}
 
-	XFREE(node->value);
-	node->value = xstrdup(value);
+	journal_record_begin(node->ast, JO_VALUE_SET, node);
+	ast_node_value_set(node, value);
+	journal_record_end(node->ast, value, NULL);
 
 	goto out;
 
@@ -1511,6 +3174,7 @@ uci2_error_e uci2_node_list_name_set(uci2_node_t *node, const char *name)
 {
 	uci2_error_e error = UE_NONE;
 	uci2_node_type_e node_type = UNT_ROOT;
+	uint64_t name_hash = 0;
 
 	if (node == NULL) {
 		error = UE_INVALID_ARGUMENT;
@@ -1540,19 +3204,16 @@ uci2_error_e uci2_node_list_name_set(uci2_node_t *node, const char *name)
 		goto error_out;
 	}
 
-	for (size_t i = 0; i < node->parent->children_number; i++) {
-		if (node->parent->children[i] &&
-			node->parent->children[i]->parent &&
-			node->parent->children[i]->name &&
-			strcmp(node->parent->children[i]->name, name) == 0) {
-			DEBUG("list named '%s' already exists", node->parent->children[i]->name);
-			error = UE_NODE_DUPLICATE;
-			goto error_out;
-		}
+	name_hash = hash_string(name);
+	if (index_child_find(node->parent, name, name_hash)) {
+		DEBUG("list named '%s' already exists", name);
+		error = UE_NODE_DUPLICATE;
+		goto error_out;
 	}
 
-	XFREE(node->name);
-	node->name = xstrdup(name);
+	journal_record_begin(node->ast, JO_NAME_SET, node);
+	ast_node_name_set(node, name);
+	journal_record_end(node->ast, name, NULL);
 
 	goto out;
 
@@ -1642,13 +3303,190 @@ uci2_error_e uci2_node_list_element_value_set(uci2_node_t *node, const char *val
 		goto error_out;
 	}
 
-	XFREE(node->name);
-	node->name = xstrdup(value);
+	journal_record_begin(node->ast, JO_VALUE_SET, node);
+	ast_node_name_set(node, value);
+	journal_record_end(node->ast, value, NULL);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_list_contains(uci2_node_t *node, const char *value, bool *out)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e node_type = UNT_ROOT;
+
+	if (node == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (value == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (out == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (node->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	error = uci2_node_type_get(node, &node_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	if (node_type != UNT_LIST) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	// list elements are indexed by value like options by name
+	*out = index_child_find(node, value, hash_string(value)) != NULL;
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_list_remove_value(uci2_node_t *node, const char *value)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e node_type = UNT_ROOT;
+	uci2_node_t *element_node = NULL;
+	uint64_t value_hash = 0;
+	size_t removed = 0;
+
+	if (node == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (value == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (node->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	error = uci2_node_type_get(node, &node_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	if (node_type != UNT_LIST) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	journal_record_begin(node->ast, JO_LIST_VALUE_REMOVE, node);
+
+	value_hash = hash_string(value);
+	while ((element_node = index_child_find(node, value, value_hash))) {
+		ast_node_remove(element_node);
+		removed++;
+	}
+
+	if (removed == 0) {
+		DEBUG("could not find list element node");
+		journal_record_cancel(node->ast);
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	journal_record_end(node->ast, value, NULL);
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
+
+uci2_error_e uci2_node_list_unique(uci2_node_t *node)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_node_type_e node_type = UNT_ROOT;
+	uci2_node_t *element_node = NULL;
+	uci2_node_t *seen_node = NULL;
+	hash_table_t seen = {0};
+	size_t position = 0;
+
+	if (node == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (node->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	error = uci2_node_type_get(node, &node_type);
+	if (error) {
+		DEBUG("uci2_node_type_get error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	if (node_type != UNT_LIST) {
+		DEBUG("node type mismatch");
+		error = UE_NODE_TYPE_MISMATCH;
+		goto error_out;
+	}
+
+	journal_record_begin(node->ast, JO_LIST_UNIQUE, node);
+
+	// the first element with a value stays, so the list keeps its order
+	hash_table_init(&seen);
+	ast_node_children_order(node);
+	for (size_t i = 0; i < node->children_number; i++) {
+		element_node = node->children[i];
+		if (element_node->parent == NULL || element_node->name == NULL) {
+			continue;
+		}
+
+		position = HASH_TABLE_POSITION_START;
+		while ((seen_node = hash_table_find(&seen, element_node->name_hash, &position))) {
+			if (strcmp(seen_node->name, element_node->name) == 0) {
+				break;
+			}
+		}
+
+		if (seen_node) {
+			ast_node_remove(element_node);
+		} else {
+			hash_table_insert(&seen, element_node->name_hash, element_node);
+		}
+	}
+
+	journal_record_end(node->ast, NULL, NULL);
 
 	goto out;
 
 error_out:
 out:
+	hash_table_destroy(&seen);
+
 	return error;
 }
 
@@ -1707,3 +3545,58 @@ const char *uci2_error_description_get(uci2_error_e error)
 			return "undefined uci2_error_e";
 	}
 }
+
+static uci2_error_e uci2_node_move(uci2_node_t *node, uci2_node_t *anchor, bool after)
+{
+	uci2_error_e error = UE_NONE;
+	size_t position = 0;
+	size_t anchor_position = 0;
+
+	if (node == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (anchor == NULL) {
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (node->parent == NULL || anchor->parent == NULL) {
+		DEBUG("node deleted");
+		error = UE_NODE_NOT_FOUND;
+		goto error_out;
+	}
+
+	// sections move within their type, options and lists within their section, elements within their list
+	if (node->parent != anchor->parent) {
+		DEBUG("nodes do not share a parent");
+		error = UE_INVALID_ARGUMENT;
+		goto error_out;
+	}
+
+	if (node == anchor) {
+		goto out;
+	}
+
+	ast_node_children_sequence_get(node->parent);
+	position = sequence_position_get(&node->sibling_link);
+	anchor_position = sequence_position_get(&anchor->sibling_link);
+
+	// the anchor moves up by one when the node leaves from in front of it
+	if (position < anchor_position) {
+		anchor_position--;
+	}
+
+	error = uci2_node_set_position(node, after ? anchor_position + 1 : anchor_position);
+	if (error) {
+		DEBUG("uci2_node_set_position error (%d): %s", error, uci2_error_description_get(error));
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+out:
+	return error;
+}
@@ -7,6 +7,7 @@
 #define UCI2_H_ONCE
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define UCI2_VERSION_MAJOR 2
@@ -16,6 +17,9 @@
 typedef struct ast_s uci2_ast_t;
 typedef struct ast_node_s uci2_node_t;
 typedef struct uci2_node_iterator_s uci2_node_iterator_t;
+typedef struct uci2_parser_s uci2_parser_t;
+typedef struct uci2_query_s uci2_query_t;
+typedef struct uci2_builder_s uci2_builder_t;
 
 typedef enum {
 #define UCI2_ERROR_TABLE                                        \
@@ -28,7 +32,8 @@ typedef enum {
 	XM(UE_NODE_TYPE_MISMATCH, -6, "Node type mismatch")         \
 	XM(UE_NODE_ATTRIBUTE_MISSING, -7, "Node attribute missing") \
 	XM(UE_NODE_DUPLICATE, -8, "Node name already exists")       \
-	XM(UE_ITERATOR_END, -9, "Iterator reached the end")
+	XM(UE_ITERATOR_END, -9, "Iterator reached the end")         \
+	XM(UE_TRANSACTION, -10, "Transaction already open or not open")
 
 #define XM(ENUM, CODE, DESCRIPTION) ENUM = CODE,
 	UCI2_ERROR_TABLE
@@ -43,31 +48,99 @@ typedef enum {
 	UNT_LIST_ELEMENT,
 } uci2_node_type_e;
 
+typedef uci2_error_e (*uci2_config_reader_t)(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read);
+typedef void (*uci2_search_callback_t)(void *user_data, uci2_node_t *node);
+
+typedef struct {
+	size_t line;
+	size_t column;
+	char *token;
+	char *message;
+} uci2_diagnostic_t;
+
+typedef struct {
+	const char *section;
+	const char *option;
+} uci2_key_t;
+
+typedef struct {
+	const char *option;
+	const char *value;
+} uci2_predicate_t;
+
 uint32_t uci2_version_numeric(void);
 const char *uci2_version_string(void);
+const char *uci2_kernel_variant_get(void);
 
 uci2_error_e uci2_config_parse(const char *config, uci2_ast_t **out);
+uci2_error_e uci2_config_parse_reader(uci2_config_reader_t reader, void *user_data, uci2_ast_t **out);
+uci2_error_e uci2_config_parse_batch(const char **configs, size_t configs_number, uci2_ast_t **out, uci2_error_e *out_errors);
+uci2_error_e uci2_config_parse_recover(const char *config, uci2_ast_t **out, uci2_diagnostic_t **diagnostics, size_t *diagnostics_number);
+void uci2_diagnostics_destroy(uci2_diagnostic_t **diagnostics, size_t diagnostics_number);
 uci2_error_e uci2_config_remove(const char *config);
 
+uci2_error_e uci2_parser_create(uci2_parser_t **out);
+uci2_error_e uci2_parser_parse(uci2_parser_t *parser, const char *config, uci2_ast_t **out);
+uci2_error_e uci2_parser_parse_reader(uci2_parser_t *parser, uci2_config_reader_t reader, void *user_data, uci2_ast_t **out);
+uci2_error_e uci2_parser_parse_buffer(uci2_parser_t *parser, const char *buffer, size_t buffer_size, uci2_ast_t **out);
+uci2_error_e uci2_parser_recover_set(uci2_parser_t *parser, bool recover);
+uci2_error_e uci2_parser_diagnostics_get(uci2_parser_t *parser, const uci2_diagnostic_t **out, size_t *out_number);
+void uci2_parser_destroy(uci2_parser_t **parser);
+
+uci2_error_e uci2_builder_create(uci2_builder_t **out);
+uci2_error_e uci2_builder_section_add(uci2_builder_t *builder, const char *type, const char *name);
+uci2_error_e uci2_builder_option_add(uci2_builder_t *builder, const char *name, const char *value);
+uci2_error_e uci2_builder_list_add(uci2_builder_t *builder, const char *name, const char *value);
+uci2_error_e uci2_builder_finish(uci2_builder_t *builder, uci2_ast_t **out);
+void uci2_builder_destroy(uci2_builder_t **builder);
+
 uci2_error_e uci2_ast_create(uci2_ast_t **out);
 uci2_error_e uci2_ast_sync(uci2_ast_t *uci2_ast, const char *config);
+uci2_error_e uci2_ast_clone(uci2_ast_t *uci2_ast, uci2_ast_t **out);
 void uci2_ast_destroy(uci2_ast_t **uci2_ast);
 
+uci2_error_e uci2_txn_begin(uci2_ast_t *uci2_ast);
+uci2_error_e uci2_txn_commit(uci2_ast_t *uci2_ast);
+uci2_error_e uci2_txn_rollback(uci2_ast_t *uci2_ast);
+
+uci2_error_e uci2_journal_open(uci2_ast_t *uci2_ast, const char *path);
+uci2_error_e uci2_journal_commit(uci2_ast_t *uci2_ast, const char *config);
+uci2_error_e uci2_journal_close(uci2_ast_t *uci2_ast);
+
 uci2_error_e uci2_node_get(uci2_ast_t *uci2_ast, const char *section, const char *option, uci2_node_t **out);
+uci2_error_e uci2_node_get_many(uci2_ast_t *uci2_ast, const uci2_key_t *keys, size_t keys_number, uci2_node_t **out_nodes, uci2_error_e *out_errors);
+uci2_error_e uci2_query_compile(const char *expression, uci2_query_t **out);
+uci2_error_e uci2_query_exec(uci2_ast_t *uci2_ast, const uci2_query_t *query, uci2_node_t **out);
+void uci2_query_destroy(uci2_query_t **query);
 uci2_error_e uci2_node_section_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *type, const char *name, uci2_node_t **out);
 uci2_error_e uci2_node_option_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *name, const char *value, uci2_node_t **out);
 uci2_error_e uci2_node_list_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *name, uci2_node_t **out);
 uci2_error_e uci2_node_list_element_add(uci2_ast_t *uci2_ast, uci2_node_t *parent, const char *value, uci2_node_t **out);
 void uci2_node_remove(uci2_node_t *node);
+uci2_error_e uci2_node_move_before(uci2_node_t *node, uci2_node_t *anchor);
+uci2_error_e uci2_node_move_after(uci2_node_t *node, uci2_node_t *anchor);
+uci2_error_e uci2_node_set_position(uci2_node_t *node, size_t index);
 
 uci2_error_e uci2_node_iterator_new(uci2_node_t *node, uci2_node_iterator_t **out);
+uci2_error_e uci2_node_iterator_new_by_type(uci2_ast_t *uci2_ast, const char *type, uci2_node_iterator_t **out);
 void uci2_node_iterator_destroy(uci2_node_iterator_t **node_iterator);
 uci2_error_e uci2_node_iterator_next(uci2_node_iterator_t *node_iterator, uci2_node_t **out);
+uci2_error_e uci2_section_count(uci2_ast_t *uci2_ast, const char *type, size_t *out);
+uci2_error_e uci2_node_iterator_new_by_value(uci2_ast_t *uci2_ast, const char *value, uci2_node_iterator_t **out);
+uci2_error_e uci2_value_index_enable(uci2_ast_t *uci2_ast);
+uci2_error_e uci2_node_iterator_new_by_name_range(uci2_ast_t *uci2_ast, const char *from, const char *to, uci2_node_iterator_t **out);
+uci2_error_e uci2_node_iterator_new_by_name_prefix(uci2_ast_t *uci2_ast, const char *prefix, uci2_node_iterator_t **out);
+uci2_error_e uci2_section_name_index_enable(uci2_ast_t *uci2_ast);
+uci2_error_e uci2_search(uci2_ast_t *uci2_ast, const char *substring, uci2_search_callback_t callback, void *user_data);
+uci2_error_e uci2_search_index_enable(uci2_ast_t *uci2_ast);
+uci2_error_e uci2_index_memory_get(uci2_ast_t *uci2_ast, size_t *out);
+uci2_error_e uci2_section_select(uci2_ast_t *uci2_ast, const char *type, const uci2_predicate_t *predicates, size_t predicates_number, uci2_node_iterator_t **out);
 uci2_error_e uci2_node_type_get(uci2_node_t *node, uci2_node_type_e *out);
 
 uci2_error_e uci2_node_section_type_get(uci2_node_t *node, const char **type);
 uci2_error_e uci2_node_section_type_set(uci2_node_t *node, const char *type);
 uci2_error_e uci2_node_section_name_get(uci2_node_t *node, const char **name);
+uci2_error_e uci2_node_section_name_format(uci2_node_t *node, char *buffer, size_t buffer_size);
 uci2_error_e uci2_node_section_name_set(uci2_node_t *node, const char *name);
 
 uci2_error_e uci2_node_option_name_get(uci2_node_t *node, const char **name);
@@ -80,6 +153,9 @@ uci2_error_e uci2_node_list_name_set(uci2_node_t *node, const char *name);
 
 uci2_error_e uci2_node_list_element_value_get(uci2_node_t *node, const char **value);
 uci2_error_e uci2_node_list_element_value_set(uci2_node_t *node, const char *value);
+uci2_error_e uci2_node_list_contains(uci2_node_t *node, const char *value, bool *out);
+uci2_error_e uci2_node_list_remove_value(uci2_node_t *node, const char *value);
+uci2_error_e uci2_node_list_unique(uci2_node_t *node);
 
 uci2_error_e uci2_string_to_boolean(const char *string_value, bool *out);
 
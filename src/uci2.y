@@ -5,12 +5,20 @@
 
     #include "parser.h"
     #include "lexer.h"
+    #include "scanner.h"
 
     // external functions
     extern int yylex(YYSTYPE *lvalp, yyscan_t scanner);
     extern void yyerror(yyscan_t scanner, ast_t *ast, const char *string);
 }
 
+%code {
+    // syntax error message buffer size
+    #define SYNTAX_ERROR_MESSAGE_SIZE (256)
+    // maximum number of expected tokens listed in the syntax error message
+    #define SYNTAX_ERROR_EXPECTED_MAX (4)
+}
+
 %code requires {
     #include "utils/memory.h"
 
@@ -26,7 +34,7 @@
 %output  "parser.c"
 %defines "parser.h"
 %define api.pure full
-%define parse.error verbose
+%define parse.error custom
 %lex-param   { yyscan_t *scanner }
 %parse-param { yyscan_t *scanner }
 %parse-param { ast_t *ast }
@@ -38,19 +46,23 @@
 
 // token types
 %union {
-    char *string;
+    // unquoted token string and its hash, computed by the lexer while copying
+    struct {
+        char *string;
+        uint64_t hash;
+    } value;
     ast_node_t *node;
 }
 
 // terminal symbols (tokens)
-%token <string>    VALUE
+%token <value>     VALUE
 %token          CONFIG OPTION LIST PACKAGE
 
 // non terminal symbol types
 %type <node>    config options option lines line root package
 
 // free string memory for discarded symbols (xcalloc in lex)
-%destructor { XFREE($$); } VALUE
+%destructor { XFREE($$.string); } VALUE
 
 // set root node
 %start root
@@ -68,9 +80,7 @@ root : lines {
                  // use children from lines
                  ast_node_move($$->children[0], $1);
                  // merge section type nodes with the same name into a single node
-                 ast_node_merge($$->children[0], ANT_SECTION_TYPE);
-                 // set correct names for unnamed section nodes
-                 unnamed_section_name_set($$->children[0]);
+                 ast_node_merge($$->children[0]);
              }
         | package lines {
                             $$ = ast_node_new(ast, ANT_ROOT, xstrdup(AST_NODE_ROOT_NAME), 0);
@@ -84,14 +94,12 @@ root : lines {
                             // use children from lines
                             ast_node_move($$->children[1], $2);
                             // merge section type nodes with the same name into a single node
-                            ast_node_merge($$->children[1], ANT_SECTION_TYPE);
-                            // set correct names for unnamed section nodes
-                            unnamed_section_name_set($$->children[1]);
+                            ast_node_merge($$->children[1]);
                         }
      ;
 
 package : PACKAGE VALUE {
-                            $$ = ast_node_new(ast, ANT_PACKAGE, xstrdup(AST_NODE_PACKAGE_NAME), $2);
+                            $$ = ast_node_new(ast, ANT_PACKAGE, xstrdup(AST_NODE_PACKAGE_NAME), $2.string);
                         }
         ;
 
@@ -100,10 +108,15 @@ lines : line {
                  // Use node type ANT_SENTINEL because this node is a temporary node
                  // whose children are going to be added to the node type ANT_CONFIG in the next step.
                  $$ = ast_node_new(ast, ANT_SENTINEL, NULL, NULL);
-                 ast_node_add($$, $1);
+                 // a skipped line has no node
+                 if ($1) {
+                     ast_node_add($$, $1);
+                 }
              }
       | lines line {
-                       ast_node_add($1, $2);
+                       if ($2) {
+                           ast_node_add($1, $2);
+                       }
                    }
       ;
 
@@ -111,50 +124,63 @@ lines : line {
 line : config {
                   $$ = $1;
               }
+     | error {
+                 // the parser resynchronizes at the next config keyword, the broken section is skipped
+                 if (!((scanner_input_t *) yyget_extra(scanner))->recover) {
+                     YYABORT;
+                 }
+                 $$ = NULL;
+             }
      ;
 
+// config keyword, report syntax errors again as soon as a new section starts
+config_keyword : CONFIG {
+                            yyerrok;
+                        }
+               ;
+
 // config line
-config : CONFIG VALUE {
-                          $$ = ast_node_new(ast, ANT_SECTION_TYPE, $2, NULL);
+config : config_keyword VALUE {
+                          $$ = ast_node_new_hashed(ast, ANT_SECTION_TYPE, $2.string, $2.hash, NULL, 0);
                           // ** un-named section **
-                          // create new AST for unnamed section
+                          // create new AST for unnamed section, it has no name and is addressed by position as @type[N]
                           ast_node_t *node = NULL;
-                          node = ast_node_new(ast, ANT_SECTION_NAME, xstrdup(UNNAMED_SECTION_NAME_PLACEHOLDER), NULL);
+                          node = ast_node_new(ast, ANT_SECTION_NAME, NULL, NULL);
                           ast_node_add($$, node);
                       }
-        | CONFIG VALUE VALUE {
-                                 $$ = ast_node_new(ast, ANT_SECTION_TYPE, $2, NULL);
+        | config_keyword VALUE VALUE {
+                                 $$ = ast_node_new_hashed(ast, ANT_SECTION_TYPE, $2.string, $2.hash, NULL, 0);
                                  // ** named section **
                                  // create new AST for named section
                                  ast_node_t *node = NULL;
-                                 node = ast_node_new(ast, ANT_SECTION_NAME, $3, NULL);
+                                 node = ast_node_new_hashed(ast, ANT_SECTION_NAME, $3.string, $3.hash, NULL, 0);
                                  ast_node_add($$, node);
                              }
-        | CONFIG VALUE options {
-                                   $$ = ast_node_new(ast, ANT_SECTION_TYPE, $2, NULL);
+        | config_keyword VALUE options {
+                                   $$ = ast_node_new_hashed(ast, ANT_SECTION_TYPE, $2.string, $2.hash, NULL, 0);
                                    // ** un-named section **
-                                   // create new AST for unnamed section
+                                   // create new AST for unnamed section, it has no name and is addressed by position as @type[N]
                                    ast_node_t *node = NULL;
-                                   node = ast_node_new(ast, ANT_SECTION_NAME, xstrdup(UNNAMED_SECTION_NAME_PLACEHOLDER), NULL);
+                                   node = ast_node_new(ast, ANT_SECTION_NAME, NULL, NULL);
                                    ast_node_add($$, node);
                                    // - use children from options
                                    // - both section and type present
                                    ast_node_move($$->children[0], $3);
                                    // merge list nodes with the same name into a single node
-                                   ast_node_merge($$->children[0], ANT_LIST);
+                                   ast_node_merge($$->children[0]);
                               }
-       | CONFIG VALUE VALUE options {
-                                        $$ = ast_node_new(ast, ANT_SECTION_TYPE, $2, NULL);
+       | config_keyword VALUE VALUE options {
+                                        $$ = ast_node_new_hashed(ast, ANT_SECTION_TYPE, $2.string, $2.hash, NULL, 0);
                                         // ** named section **
                                         // create new AST for section name
                                         ast_node_t *node = NULL;
-                                        node = ast_node_new(ast, ANT_SECTION_NAME, $3, NULL);
+                                        node = ast_node_new_hashed(ast, ANT_SECTION_NAME, $3.string, $3.hash, NULL, 0);
                                         ast_node_add($$, node);
                                         // - use children from options
                                         // - both section and type present
                                         ast_node_move($$->children[0], $4);
                                         // merge list nodes with the same name into a single node
-                                        ast_node_merge($$->children[0], ANT_LIST);
+                                        ast_node_merge($$->children[0]);
                                     };
 
 // options, recursive
@@ -171,18 +197,49 @@ options : option {
 
 // option or list
 option : OPTION VALUE VALUE {
-                                $$ = ast_node_new(ast, ANT_OPTION, $2, $3);
+                                $$ = ast_node_new_hashed(ast, ANT_OPTION, $2.string, $2.hash, $3.string, $3.hash);
                             }
         | LIST VALUE {
-                              $$ = ast_node_new(ast, ANT_LIST, $2, NULL);
+                              $$ = ast_node_new_hashed(ast, ANT_LIST, $2.string, $2.hash, NULL, 0);
                           }
        | LIST VALUE VALUE {
-                              $$ = ast_node_new(ast, ANT_LIST, $2, NULL);
+                              $$ = ast_node_new_hashed(ast, ANT_LIST, $2.string, $2.hash, NULL, 0);
                               // add list value as new node
                               ast_node_t *node = NULL;
-                              node = ast_node_new(ast, ANT_LIST_ITEM, $3, NULL);
+                              node = ast_node_new_hashed(ast, ANT_LIST_ITEM, $3.string, $3.hash, NULL, 0);
                               ast_node_add($$, node);
                           }
        ;
 
 %%
+
+// report a syntax error at the lookahead token
+static int yyreport_syntax_error(const yypcontext_t *context, yyscan_t *scanner, ast_t *ast)
+{
+    scanner_input_t *input = yyget_extra(scanner);
+    yysymbol_kind_t token = yypcontext_token(context);
+    yysymbol_kind_t expected[SYNTAX_ERROR_EXPECTED_MAX] = {0};
+    int expected_number = 0;
+    char message[SYNTAX_ERROR_MESSAGE_SIZE] = {0};
+    size_t message_size = 0;
+
+    (void) ast;
+
+    // same text as parse.error verbose, expected tokens are listed only if there are few of them
+    message_size += (size_t) snprintf(message, sizeof(message), "syntax error, unexpected %s", yysymbol_name(token));
+    expected_number = yypcontext_expected_tokens(context, expected, SYNTAX_ERROR_EXPECTED_MAX);
+    for (int i = 0; i < expected_number && message_size < sizeof(message); i++) {
+        message_size += (size_t) snprintf(message + message_size, sizeof(message) - message_size, "%s %s", i == 0 ? ", expecting" : " or", yysymbol_name(expected[i]));
+    }
+
+    if (!input->recover) {
+        yyerror(scanner, ast, message);
+    } else if (token == YYSYMBOL_YYEOF) {
+        // end of input has no text, it is located after the last character
+        scanner_input_diagnostic_add(input, input->line, input->column, "", message);
+    } else {
+        scanner_input_diagnostic_add(input, input->token_line, input->token_column, yyget_text(scanner), message);
+    }
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include "hash.h"
+
+uint64_t hash_bytes(const void *bytes, size_t size)
+{
+	const unsigned char *byte = bytes;
+	uint64_t hash = HASH_SEED;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = HASH_BYTE(hash, byte[i]);
+	}
+
+	return hash;
+}
+
+uint64_t hash_string(const char *string)
+{
+	uint64_t hash = HASH_SEED;
+
+	if (string == NULL) {
+		return 0;
+	}
+
+	for (; *string; string++) {
+		hash = HASH_BYTE(hash, *string);
+	}
+
+	return hash;
+}
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef HASH_H_ONCE
+#define HASH_H_ONCE
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 64-bit FNV-1a, usable incrementally while the bytes are being copied
+#define HASH_SEED UINT64_C(0xcbf29ce484222325)
+#define HASH_PRIME UINT64_C(0x100000001b3)
+#define HASH_BYTE(hash, byte) (((hash) ^ (uint64_t) (unsigned char) (byte)) * HASH_PRIME)
+
+uint64_t hash_bytes(const void *bytes, size_t size);
+uint64_t hash_string(const char *string);
+
+#endif /* HASH_H_ONCE */
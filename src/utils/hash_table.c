@@ -0,0 +1,163 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <assert.h>
+
+#include "memory.h"
+#include "hash_table.h"
+
+#define HASH_TABLE_SIZE_MIN (8)
+
+static size_t hash_table_slot_get(const hash_table_t *table, uint64_t hash);
+static void hash_table_resize(hash_table_t *table, size_t size);
+
+void hash_table_init(hash_table_t *table)
+{
+	assert(table);
+
+	table->entries = NULL;
+	table->size = 0;
+	table->entries_number = 0;
+}
+
+void hash_table_destroy(hash_table_t *table)
+{
+	if (table) {
+		XFREE(table->entries);
+		table->size = 0;
+		table->entries_number = 0;
+	}
+}
+
+void hash_table_insert(hash_table_t *table, uint64_t hash, void *value)
+{
+	size_t slot = 0;
+
+	assert(table);
+	assert(value);
+
+	// keep the load factor at or below 1/2
+	if ((table->entries_number + 1) * 2 > table->size) {
+		hash_table_resize(table, table->size ? table->size * 2 : HASH_TABLE_SIZE_MIN);
+	}
+
+	// linear probing puts a value after every earlier value with the same hash
+	slot = hash_table_slot_get(table, hash);
+	while (table->entries[slot].value) {
+		slot = (slot + 1) & (table->size - 1);
+	}
+
+	table->entries[slot].hash = hash;
+	table->entries[slot].value = value;
+	table->entries_number++;
+}
+
+bool hash_table_remove(hash_table_t *table, uint64_t hash, const void *value)
+{
+	size_t slot = 0;
+	size_t next = 0;
+	size_t home = 0;
+
+	assert(table);
+
+	if (table->entries_number == 0) {
+		return false;
+	}
+
+	slot = hash_table_slot_get(table, hash);
+	while (table->entries[slot].value && table->entries[slot].value != value) {
+		slot = (slot + 1) & (table->size - 1);
+	}
+
+	if (table->entries[slot].value == NULL) {
+		return false;
+	}
+
+	// backward shift deletion, no tombstones and the order of the remaining values is kept
+	next = (slot + 1) & (table->size - 1);
+	while (table->entries[next].value) {
+		home = hash_table_slot_get(table, table->entries[next].hash);
+		// the entry at next may move into slot only if slot lies on its probe path
+		if (((next - home) & (table->size - 1)) >= ((next - slot) & (table->size - 1))) {
+			table->entries[slot] = table->entries[next];
+			slot = next;
+		}
+		next = (next + 1) & (table->size - 1);
+	}
+
+	table->entries[slot].hash = 0;
+	table->entries[slot].value = NULL;
+	table->entries_number--;
+
+	return true;
+}
+
+void *hash_table_find(const hash_table_t *table, uint64_t hash, size_t *position)
+{
+	size_t slot = 0;
+
+	assert(table);
+	assert(position);
+
+	if (table->entries_number == 0) {
+		return NULL;
+	}
+
+	// *position is HASH_TABLE_POSITION_START on the first call, the next slot to look at afterwards
+	slot = (*position == HASH_TABLE_POSITION_START) ? hash_table_slot_get(table, hash) : *position;
+	for (; table->entries[slot].value; slot = (slot + 1) & (table->size - 1)) {
+		if (table->entries[slot].hash == hash) {
+			*position = (slot + 1) & (table->size - 1);
+			return table->entries[slot].value;
+		}
+	}
+
+	*position = slot;
+
+	return NULL;
+}
+
+size_t hash_table_memory_get(const hash_table_t *table)
+{
+	assert(table);
+
+	return table->size * sizeof(hash_table_entry_t);
+}
+
+static size_t hash_table_slot_get(const hash_table_t *table, uint64_t hash)
+{
+	// fold the high bits in, FNV-1a low bits alone cluster on similar strings
+	return (size_t) (hash ^ (hash >> 32) ^ (hash >> 17)) & (table->size - 1);
+}
+
+static void hash_table_resize(hash_table_t *table, size_t size)
+{
+	hash_table_entry_t *entries = table->entries;
+	size_t entries_size = table->size;
+	size_t start = 0;
+	size_t slot = 0;
+
+	table->entries = xcalloc(size, sizeof(hash_table_entry_t));
+	table->size = size;
+	table->entries_number = 0;
+
+	if (entries == NULL) {
+		return;
+	}
+
+	// start reinserting at the beginning of a cluster so that equal hashes keep their order
+	while (entries[start].value) {
+		start++;
+	}
+
+	for (size_t i = 0; i < entries_size; i++) {
+		slot = (start + i) & (entries_size - 1);
+		if (entries[slot].value) {
+			hash_table_insert(table, entries[slot].hash, entries[slot].value);
+		}
+	}
+
+	XFREE(entries);
+}
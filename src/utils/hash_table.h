@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef HASH_TABLE_H_ONCE
+#define HASH_TABLE_H_ONCE
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// start position for hash_table_find
+#define HASH_TABLE_POSITION_START SIZE_MAX
+
+typedef struct hash_table_s hash_table_t;
+typedef struct hash_table_entry_s hash_table_entry_t;
+
+struct hash_table_entry_s {
+	uint64_t hash;
+	void *value; // NULL marks a free slot
+};
+
+// open addressing multimap from a precomputed hash to a value, values with the same hash keep their insertion order
+struct hash_table_s {
+	hash_table_entry_t *entries;
+	size_t size;
+	size_t entries_number;
+};
+
+void hash_table_init(hash_table_t *table);
+void hash_table_destroy(hash_table_t *table);
+void hash_table_insert(hash_table_t *table, uint64_t hash, void *value);
+bool hash_table_remove(hash_table_t *table, uint64_t hash, const void *value);
+void *hash_table_find(const hash_table_t *table, uint64_t hash, size_t *position);
+size_t hash_table_memory_get(const hash_table_t *table);
+
+#endif /* HASH_TABLE_H_ONCE */
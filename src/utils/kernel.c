@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "kernel.h"
+
+// SIMD variants are built with per function target attributes, no extra compiler flags are needed
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KERNEL_X86 (1)
+#include <immintrin.h>
+#endif
+
+typedef size_t (*kernel_chars_find_t)(const char *string, size_t string_size, const char *set, size_t set_size);
+
+typedef struct {
+	kernel_variant_e variant;
+	kernel_chars_find_t chars_find;
+} kernel_t;
+
+static size_t kernel_chars_find_scalar(const char *string, size_t string_size, const char *set, size_t set_size);
+#ifdef KERNEL_X86
+static size_t kernel_chars_find_sse42(const char *string, size_t string_size, const char *set, size_t set_size);
+static size_t kernel_chars_find_avx2(const char *string, size_t string_size, const char *set, size_t set_size);
+static void kernel_init(void) __attribute__((constructor));
+#endif
+
+static kernel_t kernel = {
+	.variant = KERNEL_VARIANT_SCALAR,
+	.chars_find = kernel_chars_find_scalar,
+};
+
+static const char *kernel_variant_names[] = {
+	[KERNEL_VARIANT_SCALAR] = "scalar",
+	[KERNEL_VARIANT_SSE42] = "sse4.2",
+	[KERNEL_VARIANT_AVX2] = "avx2",
+};
+
+kernel_variant_e kernel_variant_get(void)
+{
+	return kernel.variant;
+}
+
+const char *kernel_variant_name_get(kernel_variant_e variant)
+{
+	assert(variant <= KERNEL_VARIANT_AVX2);
+
+	return kernel_variant_names[variant];
+}
+
+bool kernel_variant_supported(kernel_variant_e variant)
+{
+	switch (variant) {
+		case KERNEL_VARIANT_SCALAR:
+			return true;
+#ifdef KERNEL_X86
+		case KERNEL_VARIANT_SSE42:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.2");
+		case KERNEL_VARIANT_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+
+bool kernel_variant_set(kernel_variant_e variant)
+{
+	if (kernel_variant_supported(variant) == false) {
+		return false;
+	}
+
+	switch (variant) {
+#ifdef KERNEL_X86
+		case KERNEL_VARIANT_SSE42:
+			kernel.chars_find = kernel_chars_find_sse42;
+			break;
+		case KERNEL_VARIANT_AVX2:
+			kernel.chars_find = kernel_chars_find_avx2;
+			break;
+#endif
+		default:
+			kernel.chars_find = kernel_chars_find_scalar;
+			break;
+	}
+
+	kernel.variant = variant;
+
+	return true;
+}
+
+size_t kernel_chars_find(const char *string, size_t string_size, const char *set)
+{
+	size_t set_size = strlen(set);
+
+	assert(string || string_size == 0);
+	assert(set_size > 0 && set_size <= KERNEL_SET_SIZE_MAX);
+
+	return kernel.chars_find(string, string_size, set, set_size);
+}
+
+static size_t kernel_chars_find_scalar(const char *string, size_t string_size, const char *set, size_t set_size)
+{
+	for (size_t i = 0; i < string_size; i++) {
+		for (size_t j = 0; j < set_size; j++) {
+			if (string[i] == set[j]) {
+				return i;
+			}
+		}
+	}
+
+	return string_size;
+}
+
+#ifdef KERNEL_X86
+static void kernel_init(void)
+{
+	if (kernel_variant_set(KERNEL_VARIANT_AVX2) == false) {
+		kernel_variant_set(KERNEL_VARIANT_SSE42);
+	}
+}
+
+__attribute__((target("sse4.2"))) static size_t kernel_chars_find_sse42(const char *string, size_t string_size, const char *set, size_t set_size)
+{
+	char set_buffer[16] = {0};
+	__m128i set_vector;
+	__m128i string_vector;
+	size_t i = 0;
+	int position = 0;
+
+	// the set is copied so that the 16 byte load stays inside the buffer
+	memcpy(set_buffer, set, set_size);
+	set_vector = _mm_loadu_si128((const __m128i *) set_buffer);
+
+	for (; i + 16 <= string_size; i += 16) {
+		string_vector = _mm_loadu_si128((const __m128i *) (string + i));
+		position = _mm_cmpestri(set_vector, (int) set_size, string_vector, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+		if (position < 16) {
+			return i + (size_t) position;
+		}
+	}
+
+	return i + kernel_chars_find_scalar(string + i, string_size - i, set, set_size);
+}
+
+__attribute__((target("avx2"))) static size_t kernel_chars_find_avx2(const char *string, size_t string_size, const char *set, size_t set_size)
+{
+	__m256i set_vectors[KERNEL_SET_SIZE_MAX];
+	__m256i string_vector;
+	__m256i match;
+	unsigned mask = 0;
+	size_t i = 0;
+
+	for (size_t j = 0; j < set_size; j++) {
+		set_vectors[j] = _mm256_set1_epi8(set[j]);
+	}
+
+	for (; i + 32 <= string_size; i += 32) {
+		string_vector = _mm256_loadu_si256((const __m256i *) (string + i));
+		match = _mm256_cmpeq_epi8(string_vector, set_vectors[0]);
+		for (size_t j = 1; j < set_size; j++) {
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(string_vector, set_vectors[j]));
+		}
+
+		mask = (unsigned) _mm256_movemask_epi8(match);
+		if (mask) {
+			return i + (size_t) __builtin_ctz(mask);
+		}
+	}
+
+	return i + kernel_chars_find_scalar(string + i, string_size - i, set, set_size);
+}
+#endif
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef KERNEL_H_ONCE
+#define KERNEL_H_ONCE
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// maximum number of characters in a kernel_chars_find set
+#define KERNEL_SET_SIZE_MAX (16)
+
+typedef enum {
+	KERNEL_VARIANT_SCALAR,
+	KERNEL_VARIANT_SSE42,
+	KERNEL_VARIANT_AVX2,
+} kernel_variant_e;
+
+// the best supported variant is selected once when the library is loaded
+kernel_variant_e kernel_variant_get(void);
+const char *kernel_variant_name_get(kernel_variant_e variant);
+bool kernel_variant_supported(kernel_variant_e variant);
+bool kernel_variant_set(kernel_variant_e variant);
+
+// position of the first character of string found in set, string_size if there is none
+size_t kernel_chars_find(const char *string, size_t string_size, const char *set);
+
+#endif /* KERNEL_H_ONCE */
@@ -59,6 +59,18 @@ char *xstrdup(const char *s)
 	return res;
 }
 
+char *xstrndup(const char *s, size_t n)
+{
+	char *res;
+
+	// copies exactly n bytes, s does not have to be terminated within them
+	res = xmalloc(n + 1);
+	memcpy(res, s, n);
+	res[n] = '\0';
+
+	return res;
+}
+
 uint32_t *uint32alloc(uint32_t value)
 {
 	uint32_t *res = NULL;
@@ -21,6 +21,7 @@ void *xmalloc(size_t size);
 void *xrealloc(void *ptr, size_t size);
 void *xcalloc(size_t nmemb, size_t size);
 char *xstrdup(const char *s);
+char *xstrndup(const char *s, size_t n);
 uint32_t *uint32alloc(uint32_t value);
 
 #endif /* MEMORY_H_ONCE */
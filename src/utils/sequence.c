@@ -0,0 +1,229 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <assert.h>
+
+#include "sequence.h"
+
+static size_t sequence_link_size_get(const sequence_link_t *link);
+static void sequence_link_update(sequence_link_t *link);
+static void sequence_split(sequence_link_t *link, size_t position, sequence_link_t **left, sequence_link_t **right);
+static sequence_link_t *sequence_merge(sequence_link_t *left, sequence_link_t *right);
+
+void sequence_init(sequence_t *sequence)
+{
+	assert(sequence);
+
+	sequence->root = NULL;
+}
+
+size_t sequence_size_get(const sequence_t *sequence)
+{
+	assert(sequence);
+
+	return sequence_link_size_get(sequence->root);
+}
+
+void sequence_insert(sequence_t *sequence, sequence_link_t *link, size_t position)
+{
+	sequence_link_t *left = NULL;
+	sequence_link_t *right = NULL;
+	uint64_t priority = (uint64_t) (uintptr_t) link;
+
+	assert(sequence);
+	assert(link);
+	assert(position <= sequence_size_get(sequence));
+
+	// splitmix64 of the address, random enough to keep the treap balanced and reproducible
+	priority += UINT64_C(0x9e3779b97f4a7c15);
+	priority = (priority ^ (priority >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	priority = (priority ^ (priority >> 27)) * UINT64_C(0x94d049bb133111eb);
+	priority ^= priority >> 31;
+
+	link->left = NULL;
+	link->right = NULL;
+	link->up = NULL;
+	link->size = 1;
+	link->priority = priority;
+
+	sequence_split(sequence->root, position, &left, &right);
+	sequence->root = sequence_merge(sequence_merge(left, link), right);
+	sequence->root->up = NULL;
+}
+
+void sequence_append(sequence_t *sequence, sequence_link_t *link)
+{
+	sequence_insert(sequence, link, sequence_size_get(sequence));
+}
+
+void sequence_remove(sequence_t *sequence, sequence_link_t *link)
+{
+	sequence_link_t *up = NULL;
+	sequence_link_t *children = NULL;
+
+	assert(sequence);
+	assert(link);
+
+	// the merged subtrees keep the heap order and take the place of the removed link
+	up = link->up;
+	children = sequence_merge(link->left, link->right);
+	if (children) {
+		children->up = up;
+	}
+
+	if (up == NULL) {
+		sequence->root = children;
+	} else if (up->left == link) {
+		up->left = children;
+	} else {
+		up->right = children;
+	}
+
+	for (; up; up = up->up) {
+		sequence_link_update(up);
+	}
+
+	link->left = NULL;
+	link->right = NULL;
+	link->up = NULL;
+	link->size = 0;
+}
+
+sequence_link_t *sequence_at(const sequence_t *sequence, size_t position)
+{
+	sequence_link_t *link = NULL;
+	size_t left_size = 0;
+
+	assert(sequence);
+
+	link = sequence->root;
+	while (link) {
+		left_size = sequence_link_size_get(link->left);
+		if (position < left_size) {
+			link = link->left;
+		} else if (position == left_size) {
+			return link;
+		} else {
+			position -= left_size + 1;
+			link = link->right;
+		}
+	}
+
+	return NULL;
+}
+
+size_t sequence_position_get(const sequence_link_t *link)
+{
+	size_t position = 0;
+
+	assert(link);
+
+	position = sequence_link_size_get(link->left);
+	for (; link->up; link = link->up) {
+		if (link->up->right == link) {
+			position += sequence_link_size_get(link->up->left) + 1;
+		}
+	}
+
+	return position;
+}
+
+sequence_link_t *sequence_first(const sequence_t *sequence)
+{
+	sequence_link_t *link = NULL;
+
+	assert(sequence);
+
+	link = sequence->root;
+	while (link && link->left) {
+		link = link->left;
+	}
+
+	return link;
+}
+
+sequence_link_t *sequence_next(const sequence_link_t *link)
+{
+	assert(link);
+
+	if (link->right) {
+		link = link->right;
+		while (link->left) {
+			link = link->left;
+		}
+
+		return (sequence_link_t *) link;
+	}
+
+	while (link->up && link->up->right == link) {
+		link = link->up;
+	}
+
+	return link->up;
+}
+
+static size_t sequence_link_size_get(const sequence_link_t *link)
+{
+	return link ? link->size : 0;
+}
+
+static void sequence_link_update(sequence_link_t *link)
+{
+	link->size = sequence_link_size_get(link->left) + sequence_link_size_get(link->right) + 1;
+}
+
+static void sequence_split(sequence_link_t *link, size_t position, sequence_link_t **left, sequence_link_t **right)
+{
+	size_t left_size = 0;
+
+	if (link == NULL) {
+		*left = NULL;
+		*right = NULL;
+		return;
+	}
+
+	left_size = sequence_link_size_get(link->left);
+	if (position <= left_size) {
+		sequence_split(link->left, position, left, &link->left);
+		if (link->left) {
+			link->left->up = link;
+		}
+		*right = link;
+	} else {
+		sequence_split(link->right, position - left_size - 1, &link->right, right);
+		if (link->right) {
+			link->right->up = link;
+		}
+		*left = link;
+	}
+
+	link->up = NULL;
+	sequence_link_update(link);
+}
+
+static sequence_link_t *sequence_merge(sequence_link_t *left, sequence_link_t *right)
+{
+	if (left == NULL) {
+		return right;
+	}
+
+	if (right == NULL) {
+		return left;
+	}
+
+	if (left->priority > right->priority) {
+		left->right = sequence_merge(left->right, right);
+		left->right->up = left;
+		sequence_link_update(left);
+
+		return left;
+	}
+
+	right->left = sequence_merge(left, right->left);
+	right->left->up = right;
+	sequence_link_update(right);
+
+	return right;
+}
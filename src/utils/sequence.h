@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef SEQUENCE_H_ONCE
+#define SEQUENCE_H_ONCE
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct sequence_s sequence_t;
+typedef struct sequence_link_s sequence_link_t;
+
+// link embedded in the element, an element is in at most one sequence at a time
+struct sequence_link_s {
+	sequence_link_t *left;
+	sequence_link_t *right;
+	sequence_link_t *up;
+	size_t size; // number of links in the subtree
+	uint64_t priority;
+};
+
+// ordered sequence with O(log n) insert, remove, access by position and position lookup, kept as an implicit treap
+struct sequence_s {
+	sequence_link_t *root;
+};
+
+void sequence_init(sequence_t *sequence);
+size_t sequence_size_get(const sequence_t *sequence);
+void sequence_insert(sequence_t *sequence, sequence_link_t *link, size_t position);
+void sequence_append(sequence_t *sequence, sequence_link_t *link);
+void sequence_remove(sequence_t *sequence, sequence_link_t *link);
+sequence_link_t *sequence_at(const sequence_t *sequence, size_t position);
+size_t sequence_position_get(const sequence_link_t *link);
+sequence_link_t *sequence_first(const sequence_t *sequence);
+sequence_link_t *sequence_next(const sequence_link_t *link);
+
+#endif /* SEQUENCE_H_ONCE */
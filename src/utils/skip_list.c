@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "memory.h"
+#include "skip_list.h"
+
+static skip_list_node_t *skip_list_node_new(const char *key, void *value, size_t level);
+static size_t skip_list_level_get(skip_list_t *list);
+
+void skip_list_init(skip_list_t *list)
+{
+	assert(list);
+
+	list->head = skip_list_node_new(NULL, NULL, SKIP_LIST_LEVEL_MAX);
+	list->level = 1;
+	list->size = 0;
+	list->state = UINT64_C(0x9e3779b97f4a7c15);
+}
+
+void skip_list_destroy(skip_list_t *list)
+{
+	skip_list_node_t *node = NULL;
+	skip_list_node_t *next = NULL;
+
+	if (list && list->head) {
+		for (node = list->head; node; node = next) {
+			next = node->next[0];
+			XFREE(node);
+		}
+
+		list->head = NULL;
+		list->level = 0;
+		list->size = 0;
+	}
+}
+
+void skip_list_insert(skip_list_t *list, const char *key, void *value)
+{
+	skip_list_node_t *update[SKIP_LIST_LEVEL_MAX] = {0};
+	skip_list_node_t *node = list->head;
+	size_t level = 0;
+
+	assert(list);
+	assert(key);
+	assert(value);
+
+	// insert after the equal keys already in the list
+	for (size_t i = list->level; i-- > 0;) {
+		while (node->next[i] && strcmp(node->next[i]->key, key) <= 0) {
+			node = node->next[i];
+		}
+		update[i] = node;
+	}
+
+	level = skip_list_level_get(list);
+	for (size_t i = list->level; i < level; i++) {
+		update[i] = list->head;
+	}
+	if (level > list->level) {
+		list->level = level;
+	}
+
+	node = skip_list_node_new(key, value, level);
+	for (size_t i = 0; i < level; i++) {
+		node->next[i] = update[i]->next[i];
+		update[i]->next[i] = node;
+	}
+
+	list->size++;
+}
+
+bool skip_list_remove(skip_list_t *list, const char *key, const void *value)
+{
+	skip_list_node_t *update[SKIP_LIST_LEVEL_MAX] = {0};
+	skip_list_node_t *node = list->head;
+	skip_list_node_t *target = NULL;
+
+	assert(list);
+	assert(key);
+
+	for (size_t i = list->level; i-- > 0;) {
+		while (node->next[i] && strcmp(node->next[i]->key, key) < 0) {
+			node = node->next[i];
+		}
+		update[i] = node;
+	}
+
+	for (target = node->next[0]; target && target->value != value; target = target->next[0]) {
+		if (strcmp(target->key, key) != 0) {
+			return false;
+		}
+	}
+
+	if (target == NULL || strcmp(target->key, key) != 0) {
+		return false;
+	}
+
+	// on every level of the target it is reached through nodes with the same key
+	for (size_t i = 0; i < target->level; i++) {
+		node = update[i];
+		while (node->next[i] != target) {
+			node = node->next[i];
+		}
+		node->next[i] = target->next[i];
+	}
+
+	while (list->level > 1 && list->head->next[list->level - 1] == NULL) {
+		list->level--;
+	}
+
+	XFREE(target);
+	list->size--;
+
+	return true;
+}
+
+skip_list_node_t *skip_list_lower_bound(const skip_list_t *list, const char *key)
+{
+	skip_list_node_t *node = list->head;
+
+	assert(list);
+
+	if (key == NULL) {
+		return list->head->next[0];
+	}
+
+	for (size_t i = list->level; i-- > 0;) {
+		while (node->next[i] && strcmp(node->next[i]->key, key) < 0) {
+			node = node->next[i];
+		}
+	}
+
+	return node->next[0];
+}
+
+size_t skip_list_memory_get(const skip_list_t *list)
+{
+	size_t memory = 0;
+
+	assert(list);
+
+	for (skip_list_node_t *node = list->head; node; node = node->next[0]) {
+		memory += sizeof(skip_list_node_t) + node->level * sizeof(skip_list_node_t *);
+	}
+
+	return memory;
+}
+
+static skip_list_node_t *skip_list_node_new(const char *key, void *value, size_t level)
+{
+	skip_list_node_t *node = NULL;
+
+	node = xcalloc(1, sizeof(skip_list_node_t) + level * sizeof(skip_list_node_t *));
+	node->key = key;
+	node->value = value;
+	node->level = level;
+
+	return node;
+}
+
+static size_t skip_list_level_get(skip_list_t *list)
+{
+	size_t level = 1;
+
+	// every level up is taken with probability 1/4, which keeps the average node at 1.33 pointers
+	do {
+		list->state ^= list->state << 13;
+		list->state ^= list->state >> 7;
+		list->state ^= list->state << 17;
+		if ((list->state & 3) != 0) {
+			break;
+		}
+		level++;
+	} while (level < SKIP_LIST_LEVEL_MAX);
+
+	return level;
+}
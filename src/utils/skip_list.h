@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright (C) 2024, Sartura d.d.
+ */
+
+#ifndef SKIP_LIST_H_ONCE
+#define SKIP_LIST_H_ONCE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SKIP_LIST_LEVEL_MAX (32)
+
+typedef struct skip_list_s skip_list_t;
+typedef struct skip_list_node_s skip_list_node_t;
+
+struct skip_list_node_s {
+	const char *key; // not copied, must stay valid while the node is in the list
+	void *value;
+	size_t level;
+	skip_list_node_t *next[];
+};
+
+// multimap ordered by strcmp() of the keys, values with equal keys keep their insertion order
+struct skip_list_s {
+	skip_list_node_t *head;
+	size_t level;
+	size_t size;
+	uint64_t state; // xorshift64 state for the node levels
+};
+
+void skip_list_init(skip_list_t *list);
+void skip_list_destroy(skip_list_t *list);
+void skip_list_insert(skip_list_t *list, const char *key, void *value);
+bool skip_list_remove(skip_list_t *list, const char *key, const void *value);
+skip_list_node_t *skip_list_lower_bound(const skip_list_t *list, const char *key);
+size_t skip_list_memory_get(const skip_list_t *list);
+
+#endif /* SKIP_LIST_H_ONCE */
@@ -9,6 +9,8 @@
 #include <cmocka.h>
 
 #include "utils/debug.h"
+#include "utils/hash.h"
+#include "utils/kernel.h"
 
 #include "parser.h"
 #include "lexer.h"
@@ -51,6 +53,31 @@ static void test_uci2_ast_create(void **state);
 static void test_uci2_config_remove(void **state);
 static void test_uci2_node_iterator(void **state);
 static void test_uci2_config_firewall(void **state);
+static void test_uci2_config_parse_reader(void **state);
+static void test_uci2_node_hash(void **state);
+static void test_uci2_parser(void **state);
+static void test_uci2_config_parse_recover(void **state);
+static void test_uci2_config_parse_batch(void **state);
+static void test_uci2_kernel(void **state);
+static void test_uci2_node_get_index(void **state);
+static void test_uci2_node_get_option_index(void **state);
+static void test_uci2_node_iterator_by_type(void **state);
+static void test_uci2_query(void **state);
+static void test_uci2_node_get_many(void **state);
+static void test_uci2_section_select(void **state);
+static void test_uci2_node_iterator_by_value(void **state);
+static void test_uci2_node_get_position(void **state);
+static void test_uci2_node_iterator_by_name(void **state);
+static void test_uci2_node_get_option_filter(void **state);
+static void test_uci2_node_list_set(void **state);
+static void test_uci2_search(void **state);
+static void test_uci2_node_section_add_many(void **state);
+static void test_uci2_builder(void **state);
+static void test_uci2_txn(void **state);
+static void test_uci2_journal(void **state);
+static void test_uci2_ast_clone(void **state);
+static void test_uci2_node_move(void **state);
+static void test_uci2_ast_sync_error(void **state);
 
 int main(void)
 {
@@ -81,6 +108,31 @@ int main(void)
 		cmocka_unit_test_setup_teardown(test_uci2_config_remove, setup, teardown),
 		cmocka_unit_test_setup_teardown(test_uci2_node_iterator, setup, teardown),
 		cmocka_unit_test_setup_teardown(test_uci2_config_firewall, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_config_parse_reader, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_hash, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_parser, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_config_parse_recover, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_config_parse_batch, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_kernel, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_get_index, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_get_option_index, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_iterator_by_type, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_query, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_get_many, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_section_select, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_iterator_by_value, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_get_position, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_iterator_by_name, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_get_option_filter, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_list_set, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_search, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_section_add_many, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_builder, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_txn, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_journal, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_ast_clone, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_node_move, setup, teardown),
+		cmocka_unit_test_setup_teardown(test_uci2_ast_sync_error, setup, teardown),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -105,6 +157,67 @@ static int teardown(void **state)
 	return 0;
 }
 
+static void order_get(uci2_node_iterator_t *node_iterator, char *buffer, size_t buffer_size)
+{
+	uci2_node_t *node = NULL;
+	uci2_node_type_e node_type = UNT_ROOT;
+	const char *name = NULL;
+	size_t length = 0;
+
+	buffer[0] = '\0';
+	while (uci2_node_iterator_next(node_iterator, &node) == UE_NONE) {
+		uci2_node_type_get(node, &node_type);
+		if (node_type == UNT_SECTION) {
+			uci2_node_section_name_get(node, &name);
+		} else if (node_type == UNT_OPTION) {
+			uci2_node_option_name_get(node, &name);
+		} else if (node_type == UNT_LIST) {
+			uci2_node_list_name_get(node, &name);
+		} else {
+			uci2_node_list_element_value_get(node, &name);
+		}
+
+		length += (size_t) snprintf(buffer + length, buffer_size - length, "%s%s", length ? " " : "", name);
+	}
+
+	uci2_node_iterator_destroy(&node_iterator);
+}
+
+static void search_count(void *user_data, uci2_node_t *node)
+{
+	size_t *count = user_data;
+
+	(void) node;
+	(*count)++;
+}
+
+static uci2_error_e file_reader(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read)
+{
+	FILE *file = user_data;
+
+	// hand out small chunks so that tokens get split across reads
+	if (buffer_size > 7) {
+		buffer_size = 7;
+	}
+
+	*bytes_read = fread(buffer, 1, buffer_size, file);
+
+	return ferror(file) ? UE_FILE_IO : UE_NONE;
+}
+
+static uci2_error_e failing_reader(void *user_data, char *buffer, size_t buffer_size, size_t *bytes_read)
+{
+	size_t *calls = user_data;
+
+	if ((*calls)++ > 0) {
+		return UE_FILE_IO;
+	}
+
+	*bytes_read = (size_t) snprintf(buffer, buffer_size, "config system\n\toption hostname");
+
+	return UE_NONE;
+}
+
 static void test_uci2_node_get(void **state)
 {
 	uci2_error_e error = 0;
@@ -127,7 +240,7 @@ static void test_uci2_node_section_add(void **state)
 	uci2_node_t *root_node = NULL;
 	uci2_node_t *new_section_node = NULL;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	uci2_node_t *section_node = NULL;
 	uci2_node_iterator_t *iterator = NULL;
 	uci2_node_t *node_next = NULL;
@@ -158,7 +271,7 @@ static void test_uci2_node_section_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "system");
 
-	error = uci2_node_section_name_get(new_section_node, &section_name);
+	error = uci2_node_section_name_format(new_section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "@system[1]");
 
@@ -169,7 +282,7 @@ static void test_uci2_node_section_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "system");
 
-	error = uci2_node_section_name_get(section_node, &section_name);
+	error = uci2_node_section_name_format(section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "@system[1]");
 
@@ -180,7 +293,7 @@ static void test_uci2_node_section_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "new_section_type");
 
-	error = uci2_node_section_name_get(new_section_node, &section_name);
+	error = uci2_node_section_name_format(new_section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "new_section_name");
 
@@ -189,7 +302,7 @@ static void test_uci2_node_section_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "new_section_type");
 
-	error = uci2_node_section_name_get(section_node, &section_name);
+	error = uci2_node_section_name_format(section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "new_section_name");
 
@@ -219,7 +332,7 @@ static void test_uci2_node_section_add(void **state)
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_type, section_type_match[index]);
 
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_name, section_name_match[index]);
 
@@ -241,7 +354,7 @@ static void test_uci2_node_option_add(void **state)
 	const char *option_name = NULL;
 	const char *option_value = NULL;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	uci2_node_t *option_node = NULL;
 	uci2_node_t *section_node = NULL;
 	uci2_node_iterator_t *iterator = NULL;
@@ -270,7 +383,7 @@ static void test_uci2_node_option_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "system");
 
-	error = uci2_node_section_name_get(new_section_node, &section_name);
+	error = uci2_node_section_name_format(new_section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "@system[1]");
 
@@ -357,7 +470,7 @@ static void test_uci2_node_option_add(void **state)
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_type, section_type_match[index]);
 
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_name, section_name_match[index]);
 
@@ -391,7 +504,7 @@ static void test_uci2_node_list_add(void **state)
 	uci2_node_t *new_list_node = NULL;
 	const char *list_name = NULL;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	uci2_node_t *list_node = NULL;
 	uci2_node_t *section_node = NULL;
 	uci2_node_iterator_t *iterator = NULL;
@@ -420,7 +533,7 @@ static void test_uci2_node_list_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "system");
 
-	error = uci2_node_section_name_get(new_section_node, &section_name);
+	error = uci2_node_section_name_format(new_section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "@system[1]");
 
@@ -501,7 +614,7 @@ static void test_uci2_node_list_add(void **state)
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_type, section_type_match[index]);
 
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_name, section_name_match[index]);
 
@@ -534,7 +647,7 @@ static void test_uci2_node_list_element_add(void **state)
 	uci2_node_t *new_list_element_node_2 = NULL;
 	const char *list_element_value = NULL;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	uci2_node_t *list_node = NULL;
 	uci2_node_iterator_t *iterator = NULL;
 	uci2_node_t *node_next = NULL;
@@ -552,7 +665,7 @@ static void test_uci2_node_list_element_add(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_type, "system");
 
-	error = uci2_node_section_name_get(new_section_node, &section_name);
+	error = uci2_node_section_name_format(new_section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(section_name, "@system[1]");
 
@@ -706,6 +819,7 @@ static void test_uci2_node_section_name_get(void **state)
 	uci2_ast_t *uci2_ast = NULL;
 	uci2_node_t *node = NULL;
 	const char *name = NULL;
+	char buffer[32] = {0};
 
 	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
 	assert_int_equal(error, UE_NONE);
@@ -717,6 +831,27 @@ static void test_uci2_node_section_name_get(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(name, "ntp");
 
+	error = uci2_node_section_name_format(node, buffer, sizeof(buffer));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(buffer, "ntp");
+
+	// unnamed sections have no name of their own, only a @type[N] reference
+	error = uci2_node_get(uci2_ast, "@system[0]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_name_get(node, &name);
+	assert_int_equal(error, UE_NODE_ATTRIBUTE_MISSING);
+
+	error = uci2_node_section_name_format(node, buffer, sizeof(buffer));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(buffer, "@system[0]");
+
+	error = uci2_node_section_name_format(node, buffer, 4);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_section_name_format(node, NULL, sizeof(buffer));
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
 	uci2_ast_destroy(&uci2_ast);
 }
 
@@ -725,7 +860,10 @@ static void test_uci2_node_section_name_set(void **state)
 	uci2_error_e error = 0;
 	uci2_ast_t *uci2_ast = NULL;
 	uci2_node_t *node = NULL;
+	uci2_node_t *root_node = NULL;
 	const char *name = NULL;
+	uci2_parser_t *parser = NULL;
+	const char buffer[] = "config interface '@lan'\n\toption proto 'static'\n";
 
 	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
 	assert_int_equal(error, UE_NONE);
@@ -744,6 +882,39 @@ static void test_uci2_node_section_name_set(void **state)
 	assert_int_equal(error, UE_NONE);
 	assert_string_equal(name, "test_name");
 
+	// names starting with @ are reserved for @type[N] references
+	error = uci2_node_section_name_set(node, "@timeserver[0]");
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "timeserver", "@ntp", &node);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_get(uci2_ast, "test_name", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// a parsed section named @... is still found by its exact name
+	error = uci2_parser_create(&parser);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_parser_parse_buffer(parser, buffer, sizeof(buffer) - 1, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	uci2_parser_destroy(&parser);
+
+	error = uci2_node_get(uci2_ast, "@lan", "proto", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@interface[0]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_name_get(node, &name);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(name, "@lan");
+
 	uci2_ast_destroy(&uci2_ast);
 }
 
@@ -1039,7 +1210,7 @@ static void test_uci2_config_parse_success(void **state)
 	size_t index = 0;
 	uci2_node_t *section_node = NULL;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	uci2_node_t *option_node = NULL;
 	const char *option_name = NULL;
 	const char *option_value = NULL;
@@ -1082,7 +1253,7 @@ static void test_uci2_config_parse_success(void **state)
 		assert_ptr_not_equal(section_type, NULL);
 		assert_string_equal(section_type, section_type_match[index]);
 
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_ptr_not_equal(section_name, NULL);
 		assert_string_equal(section_name, section_name_match[index]);
@@ -1101,7 +1272,7 @@ static void test_uci2_config_parse_success(void **state)
 	assert_ptr_not_equal(section_type, NULL);
 	assert_string_equal(section_type, "system");
 
-	error = uci2_node_section_name_get(section_node, &section_name);
+	error = uci2_node_section_name_format(section_node, section_name, sizeof(section_name));
 	assert_int_equal(error, UE_NONE);
 	assert_ptr_not_equal(section_name, NULL);
 	assert_string_equal(section_name, "@system[0]");
@@ -1295,7 +1466,7 @@ static void test_uci2_config_file_change(void **state)
 	uci2_node_t *new_list_node = NULL;
 	uci2_node_t *new_list_element_node = NULL;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	const char *section_type_match[] = {
 		"timeserver",
 		"new_section_type",
@@ -1442,7 +1613,7 @@ static void test_uci2_config_file_change(void **state)
 		error = uci2_node_section_type_get(node_next, &section_type);
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_type, section_type_match[index]);
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_name, section_name_match[index]);
 		index++;
@@ -1517,7 +1688,7 @@ static void test_uci2_config_file_change(void **state)
 		error = uci2_node_section_type_get(node_next, &section_type);
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_type, section_type_match[index]);
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_name, section_name_match[index]);
 		index++;
@@ -1731,7 +1902,7 @@ static void test_uci2_node_iterator(void **state)
 	size_t section_index = 0;
 	uci2_node_type_e section_node_type = UNT_ROOT;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	const char *section_type_match[] = {
 		"rule",
 		"rule",
@@ -1744,7 +1915,7 @@ static void test_uci2_node_iterator(void **state)
 		"@rule[0]",
 		"@rule[1]",
 		"rule_X",
-		"@rule[2]",
+		"@rule[3]",
 		"@rule2[0]",
 		"@rule2[1]",
 	};
@@ -1884,7 +2055,7 @@ static void test_uci2_node_iterator(void **state)
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_type, section_type_match[section_index]);
 
-		error = uci2_node_section_name_get(section_next, &section_name);
+		error = uci2_node_section_name_format(section_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_string_equal(section_name, section_name_match[section_index]);
 
@@ -2035,7 +2206,7 @@ static void test_uci2_config_firewall(void **state)
 	uci2_node_t *node_next = NULL;
 	uci2_node_type_e node_type = UNT_ROOT;
 	const char *section_type = NULL;
-	const char *section_name = NULL;
+	char section_name[64] = {0};
 	const char *section_type_match[] = {
 		"defaults",
 		"zone",
@@ -2167,7 +2338,7 @@ static void test_uci2_config_firewall(void **state)
 		"@rule[13]",
 		"@include[0]",
 		"@redirect[0]",
-		"@redirect[2]",
+		"@redirect[1]",
 	};
 
 	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_firewall", &uci2_ast);
@@ -2194,7 +2365,7 @@ static void test_uci2_config_firewall(void **state)
 		assert_ptr_not_equal(section_type, NULL);
 		assert_string_equal(section_type, section_type_match[index]);
 
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_ptr_not_equal(section_name, NULL);
 		assert_string_equal(section_name, section_name_match[index]);
@@ -2301,13 +2472,18 @@ static void test_uci2_config_firewall(void **state)
 	error = uci2_node_section_name_set(section_node, "test_name");
 	assert_int_equal(error, UE_NODE_NOT_FOUND);
 
-	error = uci2_node_get(uci2_ast, "@redirect[1]", NULL, &section_node);
+	// later sections move up to the position of the removed one
+	error = uci2_node_get(uci2_ast, "@redirect[2]", NULL, &section_node);
 	assert_int_equal(error, UE_NODE_NOT_FOUND);
 
-	error = uci2_node_get(uci2_ast, "@redirect[2]", NULL, &section_node);
+	error = uci2_node_get(uci2_ast, "@redirect[1]", NULL, &section_node);
 	assert_int_equal(error, UE_NONE);
 	assert_ptr_not_equal(section_node, NULL);
 
+	error = uci2_node_get(uci2_ast, "@redirect[-1]", NULL, &node_next);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node_next, section_node);
+
 	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
 	assert_int_equal(error, UE_NONE);
 	assert_ptr_not_equal(root_node, NULL);
@@ -2328,7 +2504,7 @@ static void test_uci2_config_firewall(void **state)
 		assert_ptr_not_equal(section_type, NULL);
 		assert_string_equal(section_type, section_type_after_delete_match[index]);
 
-		error = uci2_node_section_name_get(node_next, &section_name);
+		error = uci2_node_section_name_format(node_next, section_name, sizeof(section_name));
 		assert_int_equal(error, UE_NONE);
 		assert_ptr_not_equal(section_name, NULL);
 		assert_string_equal(section_name, section_name_after_delete_match[index]);
@@ -2340,3 +2516,2500 @@ static void test_uci2_config_firewall(void **state)
 
 	uci2_ast_destroy(&uci2_ast);
 }
+
+static void test_uci2_config_parse_reader(void **state)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_ast_t *uci2_ast = NULL;
+	FILE *file = NULL;
+	uci2_node_t *node = NULL;
+	const char *option_value = NULL;
+	const char *list_element_value = NULL;
+	uci2_node_iterator_t *iterator = NULL;
+	uci2_node_t *node_next = NULL;
+	size_t index = 0;
+	size_t calls = 0;
+	const char *list_element_value_match[] = {
+		"0.openwrt.pool.ntp.org",
+		"1.openwrt.pool.ntp.org",
+		"2.openwrt.pool.ntp.org",
+		"3.openwrt.pool.ntp.org",
+	};
+
+	error = uci2_config_parse_reader(NULL, NULL, &uci2_ast);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	file = fopen(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", "r");
+	assert_ptr_not_equal(file, NULL);
+
+	error = uci2_config_parse_reader(file_reader, file, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_not_equal(uci2_ast, NULL);
+
+	fclose(file);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_get(node, &option_value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(option_value, "OpenWrt");
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new(node, &iterator);
+	assert_int_equal(error, UE_NONE);
+
+	index = 0;
+	while (uci2_node_iterator_next(iterator, &node_next) == UE_NONE) {
+		error = uci2_node_list_element_value_get(node_next, &list_element_value);
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(list_element_value, list_element_value_match[index]);
+		index++;
+	}
+	assert_int_equal(index, 4);
+
+	uci2_node_iterator_destroy(&iterator);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// empty input results in an empty AST
+	file = fopen("/dev/null", "r");
+	assert_ptr_not_equal(file, NULL);
+
+	error = uci2_config_parse_reader(file_reader, file, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_not_equal(uci2_ast, NULL);
+
+	fclose(file);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// reader errors are reported instead of a parser error
+	error = uci2_config_parse_reader(failing_reader, &calls, &uci2_ast);
+	assert_int_equal(error, UE_FILE_IO);
+	assert_ptr_equal(uci2_ast, NULL);
+}
+
+static void test_uci2_node_hash(void **state)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_iterator_t *section_iterator = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_iterator_t *option_iterator = NULL;
+	uci2_node_t *option_node = NULL;
+	uci2_node_t *node = NULL;
+	size_t index = 0;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_iterator", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	// hashes computed by the lexer match the hashes of the stored strings
+	error = uci2_node_iterator_new(root_node, &section_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	while (uci2_node_iterator_next(section_iterator, &section_node) == UE_NONE) {
+		assert_true(section_node->name_hash == hash_string(section_node->name));
+		assert_true(section_node->parent->name_hash == hash_string(section_node->parent->name));
+
+		error = uci2_node_iterator_new(section_node, &option_iterator);
+		assert_int_equal(error, UE_NONE);
+
+		while (uci2_node_iterator_next(option_iterator, &option_node) == UE_NONE) {
+			assert_true(option_node->name_hash == hash_string(option_node->name));
+			assert_true(option_node->value_hash == hash_string(option_node->value));
+			for (size_t i = 0; i < option_node->children_number; i++) {
+				assert_true(option_node->children[i]->name_hash == hash_string(option_node->children[i]->name));
+			}
+			index++;
+		}
+
+		uci2_node_iterator_destroy(&option_iterator);
+	}
+
+	uci2_node_iterator_destroy(&section_iterator);
+	assert_int_equal(index, 36);
+
+	// setters keep the hashes up to date
+	error = uci2_node_get(uci2_ast, "rule_X", "proto", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_set(node, "tcp");
+	assert_int_equal(error, UE_NONE);
+	assert_true(node->value_hash == hash_string("tcp"));
+
+	error = uci2_node_option_name_set(node, "protocol");
+	assert_int_equal(error, UE_NONE);
+	assert_true(node->name_hash == hash_string("protocol"));
+
+	error = uci2_node_get(uci2_ast, "rule_X", "protocol", &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_parser(void **state)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_parser_t *parser = NULL;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *node = NULL;
+	const char *option_value = NULL;
+	const char buffer[] = "config system\n\toption hostname 'OpenWrt'\n\nconfig timeserver 'ntp'\n\tlist server '0.openwrt.pool.ntp.org'\n";
+
+	error = uci2_parser_create(NULL);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_parser_create(&parser);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_not_equal(parser, NULL);
+
+	error = uci2_parser_parse(NULL, CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_parser_parse(parser, CONFIG_DIRECTORY_PATH_TMP "test_config_missing", &uci2_ast);
+	assert_int_equal(error, UE_FILE_NOT_FOUND);
+
+	// the same parser is used for every parse
+	for (size_t i = 0; i < 3; i++) {
+		error = uci2_parser_parse(parser, CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+		assert_int_equal(error, UE_NONE);
+		assert_ptr_not_equal(uci2_ast, NULL);
+
+		error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_node_option_value_get(node, &option_value);
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(option_value, "OpenWrt");
+
+		uci2_ast_destroy(&uci2_ast);
+	}
+
+	// a failed parse does not leave state behind for the next one
+	error = uci2_parser_parse(parser, CONFIG_DIRECTORY_PATH_TMP "test_config_incorrect", &uci2_ast);
+	assert_int_equal(error, UE_PARSER);
+	assert_ptr_equal(uci2_ast, NULL);
+
+	error = uci2_parser_parse_buffer(parser, buffer, sizeof(buffer) - 1, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_not_equal(uci2_ast, NULL);
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// an empty buffer results in an empty AST
+	error = uci2_parser_parse_buffer(parser, NULL, 0, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_not_equal(uci2_ast, NULL);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	uci2_parser_destroy(&parser);
+	assert_ptr_equal(parser, NULL);
+}
+
+static void test_uci2_config_parse_recover(void **state)
+{
+	uci2_error_e error = UE_NONE;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_diagnostic_t *diagnostics = NULL;
+	size_t diagnostics_number = 0;
+	uci2_parser_t *parser = NULL;
+	const uci2_diagnostic_t *parser_diagnostics = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *iterator = NULL;
+	uci2_node_t *node_next = NULL;
+	const char *option_value = NULL;
+	size_t index = 0;
+	const char buffer[] = "config system\n\toption hostname\n\noption orphan '1'\nconfig timeserver 'ntp'\n\toption enabled '1'\nconfig rule 'a' 'b'\nconfig zone 'lan'\n\toption name 'lan'\n\tlist";
+
+	error = uci2_config_parse_recover(CONFIG_DIRECTORY_PATH_TMP "test_config_incorrect", &uci2_ast, NULL, &diagnostics_number);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// the broken system section is skipped, parsing resumes at the next config line
+	error = uci2_config_parse_recover(CONFIG_DIRECTORY_PATH_TMP "test_config_incorrect", &uci2_ast, &diagnostics, &diagnostics_number);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_not_equal(uci2_ast, NULL);
+	assert_int_equal(diagnostics_number, 1);
+	assert_int_equal(diagnostics[0].line, 5);
+	assert_int_equal(diagnostics[0].column, 21);
+	assert_string_equal(diagnostics[0].token, "'");
+	assert_string_equal(diagnostics[0].message, "syntax error, unexpected invalid token, expecting VALUE");
+
+	error = uci2_node_get(uci2_ast, "@system[0]", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new(node, &iterator);
+	assert_int_equal(error, UE_NONE);
+
+	index = 0;
+	while (uci2_node_iterator_next(iterator, &node_next) == UE_NONE) {
+		index++;
+	}
+	assert_int_equal(index, 4);
+
+	uci2_node_iterator_destroy(&iterator);
+	uci2_diagnostics_destroy(&diagnostics, diagnostics_number);
+	assert_ptr_equal(diagnostics, NULL);
+	uci2_ast_destroy(&uci2_ast);
+
+	// every broken section is reported in a single pass
+	error = uci2_parser_create(&parser);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_parser_recover_set(parser, true);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_parser_parse_buffer(parser, buffer, sizeof(buffer) - 1, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_parser_diagnostics_get(parser, &parser_diagnostics, &diagnostics_number);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(diagnostics_number, 3);
+	assert_int_equal(parser_diagnostics[0].line, 4);
+	assert_int_equal(parser_diagnostics[0].column, 1);
+	assert_string_equal(parser_diagnostics[0].token, "option");
+	assert_int_equal(parser_diagnostics[1].line, 7);
+	assert_int_equal(parser_diagnostics[1].column, 17);
+	assert_string_equal(parser_diagnostics[1].token, "'b'");
+	assert_int_equal(parser_diagnostics[2].line, 10);
+	assert_int_equal(parser_diagnostics[2].column, 6);
+	assert_string_equal(parser_diagnostics[2].token, "");
+	assert_string_equal(parser_diagnostics[2].message, "syntax error, unexpected end of file, expecting VALUE");
+
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_get(node, &option_value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(option_value, "1");
+
+	// the section is complete before the unexpected value
+	error = uci2_node_get(uci2_ast, "a", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "lan", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// diagnostics are reset by the next parse
+	error = uci2_parser_parse(parser, CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_parser_diagnostics_get(parser, &parser_diagnostics, &diagnostics_number);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(diagnostics_number, 0);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// without recovery the first syntax error fails the parse
+	error = uci2_parser_recover_set(parser, false);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_parser_parse_buffer(parser, buffer, sizeof(buffer) - 1, &uci2_ast);
+	assert_int_equal(error, UE_PARSER);
+	assert_ptr_equal(uci2_ast, NULL);
+
+	uci2_parser_destroy(&parser);
+}
+
+static void test_uci2_config_parse_batch(void **state)
+{
+	uci2_error_e error = UE_NONE;
+	const char *configs[40] = {0};
+	uci2_ast_t *uci2_ast[40] = {0};
+	uci2_error_e errors[40] = {0};
+	uci2_node_t *node = NULL;
+	const char *option_value = NULL;
+
+	error = uci2_config_parse_batch(NULL, 0, uci2_ast, errors);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// more files than the loader keeps in flight
+	for (size_t i = 0; i < ARRAY_SIZE(configs); i++) {
+		switch (i % 4) {
+			case 0:
+				configs[i] = CONFIG_DIRECTORY_PATH_TMP "test_config_correct";
+				break;
+			case 1:
+				configs[i] = CONFIG_DIRECTORY_PATH_TMP "test_config_missing";
+				break;
+			case 2:
+				configs[i] = CONFIG_DIRECTORY_PATH_TMP "test_config_incorrect";
+				break;
+			default:
+				configs[i] = CONFIG_DIRECTORY_PATH_TMP;
+				break;
+		}
+	}
+
+	error = uci2_config_parse_batch(configs, ARRAY_SIZE(configs), uci2_ast, errors);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < ARRAY_SIZE(configs); i++) {
+		switch (i % 4) {
+			case 0:
+				assert_int_equal(errors[i], UE_NONE);
+				assert_ptr_not_equal(uci2_ast[i], NULL);
+
+				error = uci2_node_get(uci2_ast[i], "@system[0]", "hostname", &node);
+				assert_int_equal(error, UE_NONE);
+
+				error = uci2_node_option_value_get(node, &option_value);
+				assert_int_equal(error, UE_NONE);
+				assert_string_equal(option_value, "OpenWrt");
+				break;
+			case 1:
+				assert_int_equal(errors[i], UE_FILE_NOT_FOUND);
+				assert_ptr_equal(uci2_ast[i], NULL);
+				break;
+			case 2:
+				assert_int_equal(errors[i], UE_PARSER);
+				assert_ptr_equal(uci2_ast[i], NULL);
+				break;
+			default:
+				// a directory is not a configuration file
+				assert_int_equal(errors[i], UE_FILE_IO);
+				assert_ptr_equal(uci2_ast[i], NULL);
+				break;
+		}
+
+		uci2_ast_destroy(&uci2_ast[i]);
+	}
+}
+
+static void test_uci2_kernel(void **state)
+{
+	uci2_error_e error = UE_NONE;
+	kernel_variant_e variant = kernel_variant_get();
+	char string[100] = {0};
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *node = NULL;
+	const char *option_value = NULL;
+
+	assert_string_equal(uci2_kernel_variant_get(), kernel_variant_name_get(variant));
+
+	// every supported variant finds the first character of the set at any position
+	for (kernel_variant_e v = KERNEL_VARIANT_SCALAR; v <= KERNEL_VARIANT_AVX2; v++) {
+		if (kernel_variant_set(v) == false) {
+			continue;
+		}
+		assert_string_equal(uci2_kernel_variant_get(), kernel_variant_name_get(v));
+
+		memset(string, 'a', sizeof(string));
+		assert_int_equal(kernel_chars_find(string, 0, "'"), 0);
+		assert_int_equal(kernel_chars_find(string, sizeof(string), "'\"\n\t"), sizeof(string));
+
+		for (size_t i = 0; i < sizeof(string); i++) {
+			string[i] = '\t';
+			assert_int_equal(kernel_chars_find(string, sizeof(string), "'\"\n\t"), i);
+			assert_int_equal(kernel_chars_find(string, i, "'\"\n\t"), i);
+			string[sizeof(string) - 1] = '"';
+			assert_int_equal(kernel_chars_find(string, sizeof(string), "\""), sizeof(string) - 1);
+			string[sizeof(string) - 1] = 'a';
+			string[i] = 'a';
+		}
+	}
+
+	assert_true(kernel_variant_set(variant));
+
+	// values are quoted so that they read back unchanged
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_set(node, "it's \"quoted\"");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct");
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_option_value_set(node, "it's");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct");
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_get(node, &option_value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(option_value, "it's");
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_get_index(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_nodes[1000] = {0};
+	uci2_node_t *duplicate_nodes[2] = {0};
+	uci2_node_t *unnamed_node = NULL;
+	uci2_node_t *node = NULL;
+	char name[32] = {0};
+	char type[32] = {0};
+
+	error = uci2_ast_create(&uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < sizeof(section_nodes) / sizeof(section_nodes[0]); i++) {
+		snprintf(type, sizeof(type), "type%zu", i % 3);
+		snprintf(name, sizeof(name), "section%zu", i);
+		error = uci2_node_section_add(uci2_ast, root_node, type, name, &section_nodes[i]);
+		assert_int_equal(error, UE_NONE);
+
+		// the index is built by the first lookup and updated by every later add
+		error = uci2_node_get(uci2_ast, name, NULL, &node);
+		assert_int_equal(error, UE_NONE);
+		assert_ptr_equal(node, section_nodes[i]);
+	}
+
+	for (size_t i = 0; i < sizeof(section_nodes) / sizeof(section_nodes[0]); i++) {
+		snprintf(name, sizeof(name), "section%zu", i);
+		error = uci2_node_get(uci2_ast, name, NULL, &node);
+		assert_int_equal(error, UE_NONE);
+		assert_ptr_equal(node, section_nodes[i]);
+	}
+
+	// renamed sections are found only under the new name
+	error = uci2_node_section_name_set(section_nodes[10], "renamed");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "section10", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "renamed", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, section_nodes[10]);
+
+	// removed sections are not found
+	uci2_node_remove(section_nodes[20]);
+
+	error = uci2_node_get(uci2_ast, "section20", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	// unnamed sections are found by their generated name
+	error = uci2_node_section_add(uci2_ast, root_node, "unnamed", NULL, &unnamed_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@unnamed[0]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, unnamed_node);
+
+	// the same name under different section types resolves to the first live section
+	error = uci2_node_section_add(uci2_ast, root_node, "type2", "duplicate", &duplicate_nodes[0]);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "type0", "duplicate", &duplicate_nodes[1]);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "duplicate", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, duplicate_nodes[1]);
+
+	uci2_node_remove(duplicate_nodes[1]);
+
+	error = uci2_node_get(uci2_ast, "duplicate", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, duplicate_nodes[0]);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// parsed sections are indexed as well
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_node_remove(node);
+
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_get_option_index(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *option_nodes[200] = {0};
+	uci2_node_t *node = NULL;
+	char name[32] = {0};
+
+	error = uci2_ast_create(&uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "peer", "wide", &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	// options and lists share the index, which is built once the section grows wide
+	for (size_t i = 0; i < sizeof(option_nodes) / sizeof(option_nodes[0]); i++) {
+		snprintf(name, sizeof(name), "name%zu", i);
+		if (i % 2) {
+			error = uci2_node_list_add(uci2_ast, section_node, name, &option_nodes[i]);
+		} else {
+			error = uci2_node_option_add(uci2_ast, section_node, name, "value", &option_nodes[i]);
+		}
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_node_get(uci2_ast, "wide", name, &node);
+		assert_int_equal(error, UE_NONE);
+		assert_ptr_equal(node, option_nodes[i]);
+	}
+
+	error = uci2_node_option_add(uci2_ast, section_node, "name1", "value", &node);
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	error = uci2_node_list_add(uci2_ast, section_node, "name2", &node);
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	// renamed options are found only under the new name
+	error = uci2_node_option_name_set(option_nodes[100], "renamed");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "wide", "name100", &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "wide", "renamed", &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, option_nodes[100]);
+
+	error = uci2_node_list_name_set(option_nodes[101], "renamed");
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	// the first live node with the name wins once an earlier one is removed
+	uci2_node_remove(option_nodes[150]);
+
+	error = uci2_node_get(uci2_ast, "wide", "name150", &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_list_add(uci2_ast, section_node, "name150", &option_nodes[150]);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "wide", "name150", &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, option_nodes[150]);
+
+	error = uci2_node_list_name_set(option_nodes[3], "name0");
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	uci2_node_remove(option_nodes[0]);
+
+	error = uci2_node_list_name_set(option_nodes[3], "name0");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "wide", "name0", &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, option_nodes[3]);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_iterator_by_type(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_nodes[2000] = {0};
+	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *iterator = NULL;
+	const char *type = NULL;
+	size_t count = 0;
+	size_t index = 0;
+	char name[32] = {0};
+
+	error = uci2_ast_create(&uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_count(uci2_ast, "rule", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 0);
+
+	error = uci2_node_iterator_new_by_type(uci2_ast, "rule", &iterator);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_next(iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+
+	uci2_node_iterator_destroy(&iterator);
+
+	for (size_t i = 0; i < sizeof(section_nodes) / sizeof(section_nodes[0]); i++) {
+		snprintf(name, sizeof(name), "section%zu", i);
+		error = uci2_node_section_add(uci2_ast, root_node, i % 4 ? "rule" : "zone", i % 3 ? name : NULL, &section_nodes[i]);
+		assert_int_equal(error, UE_NONE);
+
+		// the count is kept up to date on every add
+		error = uci2_section_count(uci2_ast, "rule", &count);
+		assert_int_equal(error, UE_NONE);
+		assert_int_equal(count, i - i / 4);
+	}
+
+	// remove every fifth section and the first and last rule
+	for (size_t i = 0; i < sizeof(section_nodes) / sizeof(section_nodes[0]); i++) {
+		if (i % 5 == 0 || i == 1 || i == sizeof(section_nodes) / sizeof(section_nodes[0]) - 1) {
+			uci2_node_remove(section_nodes[i]);
+		}
+	}
+
+	error = uci2_section_count(uci2_ast, "zone", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 400);
+
+	error = uci2_section_count(uci2_ast, "rule", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 1500 - 300 - 2);
+
+	// live rules come in config order, removing the current one does not disturb the iteration
+	error = uci2_node_iterator_new_by_type(uci2_ast, "rule", &iterator);
+	assert_int_equal(error, UE_NONE);
+
+	count = 0;
+	index = 0;
+	while (uci2_node_iterator_next(iterator, &node) == UE_NONE) {
+		while (index % 4 == 0 || index % 5 == 0 || index == 1 || index == sizeof(section_nodes) / sizeof(section_nodes[0]) - 1) {
+			index++;
+		}
+		assert_ptr_equal(node, section_nodes[index++]);
+
+		error = uci2_node_section_type_get(node, &type);
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(type, "rule");
+
+		if (count++ % 2) {
+			uci2_node_remove(node);
+		}
+	}
+
+	uci2_node_iterator_destroy(&iterator);
+
+	error = uci2_section_count(uci2_ast, "rule", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 599);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// parsed sections are counted as well
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_count(uci2_ast, "timeserver", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 1);
+
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_node_remove(node);
+
+	error = uci2_section_count(uci2_ast, "timeserver", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 0);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_query(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_query_t *query = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *rule_node = NULL;
+	const char *value = NULL;
+	const char *invalid_expressions[] = {
+		"",
+		"firewall",
+		".@rule[0]",
+		"firewall.",
+		"firewall.@rule[0].",
+		"firewall.@rule[0].name.extra",
+		"firewall.@rule",
+		"firewall.@[0]",
+		"firewall.@rule[]",
+		"firewall.@rule[-]",
+		"firewall.@rule[-0]",
+		"firewall.@rule[1x]",
+		"firewall.@rule[99999999999999999999999]",
+	};
+	const char *missing_expressions[] = {
+		"firewall.@rule[13]",
+		"firewall.@rule[-14]",
+		"firewall.@unknown[0]",
+		"firewall.unknown",
+		"firewall.@rule[0].unknown",
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(invalid_expressions); i++) {
+		error = uci2_query_compile(invalid_expressions[i], &query);
+		assert_int_equal(error, UE_INVALID_ARGUMENT);
+		assert_null(query);
+	}
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_firewall", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_query_compile("firewall.@rule[1].name", &query);
+	assert_int_equal(error, UE_NONE);
+
+	// a compiled query is evaluated again and again
+	for (size_t i = 0; i < 3; i++) {
+		error = uci2_query_exec(uci2_ast, query, &node);
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_node_option_value_get(node, &value);
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(value, "Allow-Ping");
+	}
+
+	// positions count live sections, removing a rule moves the later ones up
+	error = uci2_node_get(uci2_ast, "@rule[0]", NULL, &rule_node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_node_remove(rule_node);
+
+	error = uci2_query_exec(uci2_ast, query, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "Allow-IGMP");
+
+	uci2_query_destroy(&query);
+	assert_null(query);
+
+	error = uci2_query_compile("firewall.@rule[-1].src_port", &query);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_query_exec(uci2_ast, query, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "80");
+
+	uci2_query_destroy(&query);
+
+	error = uci2_query_compile("firewall.@zone[-2].network", &query);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_query_exec(uci2_ast, query, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_list_name_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "network");
+
+	uci2_query_destroy(&query);
+
+	error = uci2_query_compile("firewall.@defaults[0]", &query);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_query_exec(uci2_ast, query, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_type_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "defaults");
+
+	uci2_query_destroy(&query);
+
+	// out of range positions, unknown types, sections and options are not found
+	for (size_t i = 0; i < ARRAY_SIZE(missing_expressions); i++) {
+		error = uci2_query_compile(missing_expressions[i], &query);
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_query_exec(uci2_ast, query, &node);
+		assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+		uci2_query_destroy(&query);
+	}
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// named sections
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_query_compile("system.ntp.enabled", &query);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_query_exec(uci2_ast, query, &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &rule_node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, rule_node);
+
+	uci2_query_destroy(&query);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_get_many(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *nodes[8] = {0};
+	uci2_error_e errors[8] = {0};
+	const uci2_key_t keys[] = {
+		{"ntp", "enabled"},
+		{"@system[0]", "hostname"},
+		{"ntp", "server"},
+		{"ntp", "missing"},
+		{"missing", "enabled"},
+		{"ntp", NULL},
+		{NULL, NULL},
+		{NULL, "enabled"},
+	};
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get_many(uci2_ast, keys, ARRAY_SIZE(keys), nodes, NULL);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_get_many(uci2_ast, keys, 0, nodes, errors);
+	assert_int_equal(error, UE_NONE);
+
+	// every key gets the same result as a single uci2_node_get
+	error = uci2_node_get_many(uci2_ast, keys, ARRAY_SIZE(keys), nodes, errors);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < ARRAY_SIZE(keys); i++) {
+		node = NULL;
+		error = uci2_node_get(uci2_ast, keys[i].section, keys[i].option, &node);
+		assert_int_equal(errors[i], error);
+		assert_ptr_equal(nodes[i], error ? NULL : node);
+	}
+
+	assert_int_equal(errors[0], UE_NONE);
+	assert_int_equal(errors[1], UE_NONE);
+	assert_int_equal(errors[2], UE_NONE);
+	assert_int_equal(errors[3], UE_NODE_NOT_FOUND);
+	assert_int_equal(errors[4], UE_NODE_NOT_FOUND);
+	assert_int_equal(errors[5], UE_NONE);
+	assert_int_equal(errors[6], UE_NONE);
+	assert_int_equal(errors[7], UE_INVALID_ARGUMENT);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_section_select(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *section_nodes[8] = {0};
+	uci2_node_t *option_node = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *host_node = NULL;
+	char section_name[64] = {0};
+	const char *value = NULL;
+	size_t count = 0;
+	size_t memory = 0;
+	size_t memory_churned = 0;
+	const uci2_predicate_t predicates[] = {
+		{"target", "REJECT"},
+		{"src", "lan"},
+	};
+	const uci2_predicate_t predicate_null[] = {
+		{"target", NULL},
+	};
+	const uci2_predicate_t predicate_host[] = {
+		{"mac", "aa"},
+	};
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_firewall", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_select(uci2_ast, "rule", predicate_null, 1, &node_iterator);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_section_select(uci2_ast, "rule", NULL, 1, &node_iterator);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// the last four rules reject, in config order
+	error = uci2_section_select(uci2_ast, "rule", predicates, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; (error = uci2_node_iterator_next(node_iterator, &node)) == UE_NONE; count++) {
+		section_nodes[count] = node;
+	}
+	assert_int_equal(error, UE_ITERATOR_END);
+	assert_int_equal(count, 4);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_node_section_name_format(section_nodes[0], section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(uci2_ast, section_name, "name", &option_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_get(option_node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "Support-UDP-Traceroute");
+
+	// predicates are AND-ed
+	error = uci2_section_select(uci2_ast, "rule", predicates, ARRAY_SIZE(predicates), &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; (error = uci2_node_iterator_next(node_iterator, &node)) == UE_NONE; count++) {
+		assert_ptr_equal(node, section_nodes[count == 0 ? 1 : 3]);
+	}
+	assert_int_equal(count, 2);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// setting values, adding options and removing sections updates the selection
+	error = uci2_node_option_add(uci2_ast, section_nodes[2], "src", "lan", &option_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_name_format(section_nodes[3], section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(uci2_ast, section_name, "target", &option_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(option_node, "DROP");
+	assert_int_equal(error, UE_NONE);
+
+	uci2_node_remove(section_nodes[1]);
+
+	error = uci2_section_select(uci2_ast, "rule", predicates, ARRAY_SIZE(predicates), &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, section_nodes[2]);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_node_option_value_set(option_node, "REJECT");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_select(uci2_ast, "rule", predicates, ARRAY_SIZE(predicates), &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; (error = uci2_node_iterator_next(node_iterator, &node)) == UE_NONE; count++) {
+		assert_ptr_equal(node, section_nodes[count + 2]);
+	}
+	assert_int_equal(count, 2);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// no predicates select every section of the type, an unknown type none
+	error = uci2_section_select(uci2_ast, "rule", NULL, 0, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++)
+		;
+	assert_int_equal(count, 13);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_section_select(uci2_ast, "missing", predicates, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// options of removed sections leave the equality index, churn does not grow it
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "host", NULL, &host_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_add(uci2_ast, host_node, "mac", "aa", &option_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_select(uci2_ast, "host", predicate_host, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_index_memory_get(uci2_ast, &memory);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < 1000; i++) {
+		error = uci2_node_section_add(uci2_ast, root_node, "host", NULL, &node);
+		assert_int_equal(error, UE_NONE);
+		error = uci2_node_option_add(uci2_ast, node, "mac", "aa", &option_node);
+		assert_int_equal(error, UE_NONE);
+		uci2_node_remove(node);
+	}
+
+	error = uci2_index_memory_get(uci2_ast, &memory_churned);
+	assert_int_equal(error, UE_NONE);
+	assert_true(memory_churned <= memory);
+
+	error = uci2_section_select(uci2_ast, "host", predicate_host, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, host_node);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// rolling back a removal puts the options of the section back
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_node_remove(host_node);
+
+	error = uci2_section_select(uci2_ast, "host", predicate_host, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_select(uci2_ast, "host", predicate_host, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, host_node);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_iterator_by_value(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *option_node = NULL;
+	uci2_node_t *section_node = NULL;
+	size_t memory = 0;
+	size_t memory_enabled = 0;
+	size_t count = 0;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, NULL, &node_iterator);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// without the index the tree is walked, with it the result is the same
+	error = uci2_node_iterator_new_by_value(uci2_ast, "0", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++)
+		;
+	assert_int_equal(count, 2);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_index_memory_get(uci2_ast, &memory);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_value_index_enable(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_index_memory_get(uci2_ast, &memory_enabled);
+	assert_int_equal(error, UE_NONE);
+	assert_true(memory_enabled > memory);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, "0", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++)
+		;
+	assert_int_equal(count, 2);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// options and list elements follow their setters
+	error = uci2_node_get(uci2_ast, "@system[0]", "ttylogin", &option_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(option_node, "0");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, "1", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, "1.openwrt.pool.ntp.org", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_node_list_element_value_set(node, "0");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "route", &option_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, option_node, "0", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, "0", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++)
+		;
+	assert_int_equal(count, 5);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// removing a section removes the values below it
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(section_node);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, "0", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++)
+		;
+	assert_int_equal(count, 3);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_index_memory_get(uci2_ast, NULL);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_get_position(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *section_nodes[1000] = {0};
+	char section_name[64] = {0};
+	char section[64] = {0};
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < ARRAY_SIZE(section_nodes); i++) {
+		snprintf(section, sizeof(section), "named%zu", i);
+		error = uci2_node_section_add(uci2_ast, root_node, "position", i % 10 ? NULL : section, &section_nodes[i]);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	// positions count named and unnamed sections of the type
+	error = uci2_node_get(uci2_ast, "@position[10]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, section_nodes[10]);
+
+	error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(section_name, "named10");
+
+	error = uci2_node_get(uci2_ast, "@position[-1]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, section_nodes[999]);
+
+	error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(section_name, "@position[999]");
+
+	error = uci2_node_get(uci2_ast, "@position[-1000]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, section_nodes[0]);
+
+	error = uci2_node_get(uci2_ast, "@position[1000]", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "@position[-1001]", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "@position[x]", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	// removing a section renumbers the live sections after it
+	for (size_t i = 0; i < 500; i++) {
+		uci2_node_remove(section_nodes[i * 2]);
+	}
+
+	for (size_t i = 0; i < 500; i++) {
+		snprintf(section, sizeof(section), "@position[%zu]", i);
+		error = uci2_node_get(uci2_ast, section, NULL, &node);
+		assert_int_equal(error, UE_NONE);
+		assert_ptr_equal(node, section_nodes[i * 2 + 1]);
+
+		error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(section_name, section);
+	}
+
+	error = uci2_node_get(uci2_ast, "@position[500]", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "@position[-500]", "missing", &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_iterator_by_name(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	char section_name[64] = {0};
+	size_t index = 0;
+	const char *section_names[] = {
+		"wan6",
+		"guest_iot",
+		"lan",
+		"wan",
+		"guest_kids",
+		"wanb",
+	};
+	const char *section_names_sorted[] = {
+		"guest_iot",
+		"guest_kids",
+		"lan",
+		"ntp",
+		"wan",
+		"wan6",
+		"wanb",
+	};
+	const char *section_names_prefix[] = {
+		"wan",
+		"wan_renamed",
+		"wanb",
+	};
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < ARRAY_SIZE(section_names); i++) {
+		error = uci2_node_section_add(uci2_ast, root_node, "interface", section_names[i], &node);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	error = uci2_node_iterator_new_by_name_prefix(uci2_ast, NULL, &node_iterator);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// unnamed sections are left out, without the index the names are sorted on each call
+	for (size_t enabled = 0; enabled < 2; enabled++) {
+		error = uci2_node_iterator_new_by_name_range(uci2_ast, NULL, NULL, &node_iterator);
+		assert_int_equal(error, UE_NONE);
+
+		for (index = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; index++) {
+			error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+			assert_int_equal(error, UE_NONE);
+			assert_string_equal(section_name, section_names_sorted[index]);
+		}
+		assert_int_equal(index, ARRAY_SIZE(section_names_sorted));
+		uci2_node_iterator_destroy(&node_iterator);
+
+		error = uci2_section_name_index_enable(uci2_ast);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	error = uci2_node_iterator_new_by_name_range(uci2_ast, "guest_kids", "ntp", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (index = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; index++) {
+		error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(section_name, section_names_sorted[index + 1]);
+	}
+	assert_int_equal(index, 2);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// renames and removals keep the index in order
+	error = uci2_node_get(uci2_ast, "wan6", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(node, "wan_renamed");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "interface", "wa", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "guest_iot", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(node);
+
+	error = uci2_node_iterator_new_by_name_prefix(uci2_ast, "wan", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (index = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; index++) {
+		error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(section_name, section_names_prefix[index]);
+	}
+	assert_int_equal(index, ARRAY_SIZE(section_names_prefix));
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_node_iterator_new_by_name_prefix(uci2_ast, "guest_", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_format(node, section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(section_name, "guest_kids");
+
+	error = uci2_node_iterator_next(node_iterator, &node);
+	assert_int_equal(error, UE_ITERATOR_END);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_get_option_filter(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *option_nodes[64] = {0};
+	uci2_node_t *node = NULL;
+	char name[32] = {0};
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	// probes for missing options are answered by the filter, present ones are still found
+	error = uci2_node_get(uci2_ast, "ntp", "disabled", &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < ARRAY_SIZE(option_nodes); i++) {
+		snprintf(name, sizeof(name), "option%zu", i);
+		error = uci2_node_option_add(uci2_ast, section_node, name, "1", &option_nodes[i]);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	for (size_t i = 0; i < 1000; i++) {
+		snprintf(name, sizeof(name), "missing%zu", i);
+		error = uci2_node_get(uci2_ast, "ntp", name, &node);
+		assert_int_equal(error, UE_NODE_NOT_FOUND);
+	}
+
+	// removed and renamed options leave stale names that are dropped when the filter is rebuilt
+	for (size_t i = 0; i < ARRAY_SIZE(option_nodes); i += 2) {
+		uci2_node_remove(option_nodes[i]);
+
+		snprintf(name, sizeof(name), "renamed%zu", i + 1);
+		error = uci2_node_option_name_set(option_nodes[i + 1], name);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(option_nodes); i++) {
+		snprintf(name, sizeof(name), "option%zu", i);
+		error = uci2_node_get(uci2_ast, "ntp", name, &node);
+		assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+		snprintf(name, sizeof(name), "renamed%zu", i);
+		error = uci2_node_get(uci2_ast, "ntp", name, &node);
+		if (i % 2) {
+			assert_int_equal(error, UE_NONE);
+			assert_ptr_equal(node, option_nodes[i]);
+		} else {
+			assert_int_equal(error, UE_NODE_NOT_FOUND);
+		}
+	}
+
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_list_set(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *list_node = NULL;
+	uci2_node_t *element_node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	const char *value = NULL;
+	char element[32] = {0};
+	size_t index = 0;
+	size_t position = 0;
+	bool contains = false;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &list_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_list_contains(list_node, "1.openwrt.pool.ntp.org", &contains);
+	assert_int_equal(error, UE_NONE);
+	assert_true(contains);
+
+	error = uci2_node_list_contains(list_node, "4.openwrt.pool.ntp.org", &contains);
+	assert_int_equal(error, UE_NONE);
+	assert_false(contains);
+
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &element_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_contains(element_node, "true", &contains);
+	assert_int_equal(error, UE_NODE_TYPE_MISMATCH);
+
+	// every value is added four times, the first of them stays
+	for (size_t i = 0; i < 2000; i++) {
+		snprintf(element, sizeof(element), "10.0.%zu.%zu", (i % 500) / 256, (i % 500) % 256);
+		error = uci2_node_list_element_add(uci2_ast, list_node, element, &element_node);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	for (size_t i = 0; i < 500; i++) {
+		snprintf(element, sizeof(element), "10.0.%zu.%zu", i / 256, i % 256);
+		error = uci2_node_list_contains(list_node, element, &contains);
+		assert_int_equal(error, UE_NONE);
+		assert_true(contains);
+	}
+
+	error = uci2_node_list_contains(list_node, "10.0.2.0", &contains);
+	assert_int_equal(error, UE_NONE);
+	assert_false(contains);
+
+	error = uci2_node_list_remove_value(list_node, "10.0.0.7");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_list_contains(list_node, "10.0.0.7", &contains);
+	assert_int_equal(error, UE_NONE);
+	assert_false(contains);
+
+	error = uci2_node_list_remove_value(list_node, "10.0.0.7");
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_list_unique(list_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new(list_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+
+	for (index = 0; uci2_node_iterator_next(node_iterator, &element_node) == UE_NONE; index++) {
+		error = uci2_node_list_element_value_get(element_node, &value);
+		assert_int_equal(error, UE_NONE);
+
+		// the four ntp servers come first, 10.0.0.7 was removed
+		if (index >= 4) {
+			position = index - 4 < 7 ? index - 4 : index - 3;
+			snprintf(element, sizeof(element), "10.0.%zu.%zu", position / 256, position % 256);
+			assert_string_equal(value, element);
+		}
+	}
+	assert_int_equal(index, 4 + 499);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// the element setters keep the set up to date
+	error = uci2_node_list_element_value_set(element_node, "10.0.0.7");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_list_contains(list_node, "10.0.0.7", &contains);
+	assert_int_equal(error, UE_NONE);
+	assert_true(contains);
+
+	error = uci2_node_list_contains(list_node, "10.0.1.243", &contains);
+	assert_int_equal(error, UE_NONE);
+	assert_false(contains);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_search(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *option_node = NULL;
+	uci2_node_t *node = NULL;
+	char value[32] = {0};
+	size_t count = 0;
+	size_t memory = 0;
+	size_t memory_indexed = 0;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_search(uci2_ast, "ntp", NULL, &count);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// the section name and the four list elements
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 5);
+
+	error = uci2_index_memory_get(uci2_ast, &memory);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_search_index_enable(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_index_memory_get(uci2_ast, &memory_indexed);
+	assert_int_equal(error, UE_NONE);
+	assert_true(memory_indexed > memory);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 5);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "255.255.255.0", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 1);
+
+	// shorter than a trigram
+	count = 0;
+	error = uci2_search(uci2_ast, "25", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 2);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "pool.ntp.org.", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 0);
+
+	// the index follows added, changed and removed nodes
+	error = uci2_node_get(uci2_ast, NULL, NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_add(uci2_ast, node, "timeserver", "backup_ntp", &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < 1000; i++) {
+		snprintf(value, sizeof(value), "host%zu.example.org", i);
+		error = uci2_node_option_add(uci2_ast, section_node, value, value, &option_node);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	count = 0;
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 6);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "host99", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 11);
+
+	error = uci2_node_get(uci2_ast, "backup_ntp", "host999.example.org", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "ntp.example.org");
+	assert_int_equal(error, UE_NONE);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "host99", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 10);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 7);
+
+	error = uci2_node_section_name_set(section_node, "backup");
+	assert_int_equal(error, UE_NONE);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 6);
+
+	error = uci2_index_memory_get(uci2_ast, &memory_indexed);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_node_remove(section_node);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "example", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 0);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 5);
+
+	// the postings left empty by the removed nodes are released
+	error = uci2_index_memory_get(uci2_ast, &memory);
+	assert_int_equal(error, UE_NONE);
+	assert_true(memory < memory_indexed);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_section_add_many(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *option_node = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	uci2_predicate_t predicate = {"target", "DROP"};
+	const char *name = NULL;
+	char section_name[64] = {0};
+	const char *type = NULL;
+	size_t count = 0;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	// every section joins the same type node
+	for (size_t i = 0; i < 20000; i++) {
+		error = uci2_node_section_add(uci2_ast, root_node, "rule", NULL, &section_node);
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_node_option_add(uci2_ast, section_node, "target", i % 2 ? "ACCEPT" : "DROP", &option_node);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	error = uci2_section_count(uci2_ast, "rule", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 20000);
+
+	error = uci2_node_section_name_format(section_node, section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(section_name, "@rule[19999]");
+
+	error = uci2_node_section_add(uci2_ast, root_node, "rule", "wan", &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "rule", "wan", &section_node);
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "redirect", "wan", &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_type_set(section_node, "rule");
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	error = uci2_section_select(uci2_ast, "rule", &predicate, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++) {
+	}
+	assert_int_equal(count, 10000);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// only the section changes its type, the other sections of the old type keep it
+	error = uci2_node_get(uci2_ast, "@rule[4]", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_type_set(section_node, "redirect");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_type_get(section_node, &type);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(type, "redirect");
+
+	error = uci2_node_section_name_format(section_node, section_name, sizeof(section_name));
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(section_name, "@redirect[1]");
+
+	error = uci2_section_count(uci2_ast, "rule", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 20000);
+
+	error = uci2_section_count(uci2_ast, "redirect", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 2);
+
+	error = uci2_node_get(uci2_ast, "@rule[4]", "target", &option_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_get(option_node, &name);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(name, "ACCEPT");
+
+	error = uci2_section_select(uci2_ast, "rule", &predicate, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++) {
+	}
+	assert_int_equal(count, 9999);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	error = uci2_section_select(uci2_ast, "redirect", &predicate, 1, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(uci2_node_iterator_next(node_iterator, &node), UE_NONE);
+	assert_ptr_equal(node, section_node);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// the only section of a type takes the type node along
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_type_set(section_node, "server");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_count(uci2_ast, "timeserver", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 0);
+
+	error = uci2_node_get(uci2_ast, "@server[0]", "enabled", &option_node);
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_builder(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_builder_t *builder = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	const char *value = NULL;
+	char name[32] = {0};
+	size_t count = 0;
+
+	error = uci2_builder_create(&builder);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_builder_option_add(builder, "enabled", "1");
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	// types alternate so the type nodes are merged when finished
+	for (size_t i = 0; i < 10000; i++) {
+		snprintf(name, sizeof(name), "zone%zu", i);
+		error = uci2_builder_section_add(builder, i % 2 ? "zone" : "rule", i % 4 == 0 ? NULL : name);
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_builder_option_add(builder, "name", name);
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_builder_list_add(builder, "network", "lan");
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_builder_option_add(builder, "input", "ACCEPT");
+		assert_int_equal(error, UE_NONE);
+
+		error = uci2_builder_list_add(builder, "network", "wan");
+		assert_int_equal(error, UE_NONE);
+	}
+
+	error = uci2_builder_finish(builder, &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_section_count(uci2_ast, "zone", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 5000);
+
+	error = uci2_section_count(uci2_ast, "rule", &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 5000);
+
+	error = uci2_node_get(uci2_ast, "@rule[2]", "name", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "zone4");
+
+	error = uci2_node_get(uci2_ast, "zone9999", "network", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new(node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++) {
+		error = uci2_node_list_element_value_get(node, &value);
+		assert_int_equal(error, UE_NONE);
+		assert_string_equal(value, count ? "wan" : "lan");
+	}
+	assert_int_equal(count, 2);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	// the finished AST behaves like a parsed one
+	error = uci2_node_get(uci2_ast, "zone9999", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(node, "zone9997");
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// the builder starts over after finishing
+	error = uci2_builder_option_add(builder, "enabled", "1");
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_builder_section_add(builder, "zone", "lan");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_builder_section_add(builder, "rule", "lan");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_builder_section_add(builder, "zone", "lan");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_builder_finish(builder, &uci2_ast);
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+	assert_null(uci2_ast);
+
+	uci2_builder_destroy(&builder);
+	assert_null(builder);
+}
+
+static void test_uci2_txn(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *list_node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	const char *value = NULL;
+	size_t count = 0;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_txn_before");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_TRANSACTION);
+
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_TRANSACTION);
+
+	error = uci2_value_index_enable(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_search_index_enable(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	// a batch of edits that fails half way
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "zone", "lan", &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_add(uci2_ast, section_node, "input", "ACCEPT", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_add(uci2_ast, section_node, "network", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, list_node, "lan", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "router");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "timezone", &node);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(node);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_type_set(node, "zone");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_remove_value(list_node, "1.openwrt.pool.ntp.org");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(section_node, "time");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_type_set(section_node, "server");
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(section_node);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "zone", "lan", &section_node);
+	assert_int_equal(error, UE_NODE_DUPLICATE);
+
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	// the AST is back to where the transaction began, indexes included
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_txn_after");
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_txn_before " CONFIG_DIRECTORY_PATH_TMP "test_config_txn_after"), 0);
+
+	error = uci2_node_get(uci2_ast, "lan", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "timezone", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_value(uci2_ast, "1.openwrt.pool.ntp.org", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	for (count = 0; uci2_node_iterator_next(node_iterator, &node) == UE_NONE; count++) {
+	}
+	assert_int_equal(count, 1);
+	uci2_node_iterator_destroy(&node_iterator);
+
+	count = 0;
+	error = uci2_search(uci2_ast, "ntp", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 5);
+
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_type_get(section_node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "timeserver");
+
+	// committed changes stay
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "router");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_txn_commit(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_TRANSACTION);
+
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "router");
+
+	// a transaction left open is released with the AST
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "gateway");
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_journal(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *node = NULL;
+	uci2_node_t *list_node = NULL;
+	const char *value = NULL;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_journal_commit(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct");
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal");
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// every kind of change, unnamed sections and quotes included
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_section_add(uci2_ast, root_node, "zone", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_add(uci2_ast, section_node, "name", "it's", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_add(uci2_ast, section_node, "network", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, list_node, "lan", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, list_node, "wan", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_value_set(node, "wan6");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_type_set(section_node, "forwarding");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "router");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_name_set(node, "host");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "timezone", &node);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(node);
+
+	error = uci2_node_get(uci2_ast, "ntp", "server", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_remove_value(list_node, "1.openwrt.pool.ntp.org");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_remove_value(list_node, "1.openwrt.pool.ntp.org");
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+	error = uci2_node_list_name_set(list_node, "servers");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(section_node, "time");
+	assert_int_equal(error, UE_NONE);
+
+	// a rolled back transaction leaves nothing in the journal
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(section_node, "clock");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_journal_expected");
+	assert_int_equal(error, UE_NONE);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// the base file is untouched, the journal brings the changes back
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_journal_replayed");
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_journal_expected " CONFIG_DIRECTORY_PATH_TMP "test_config_journal_replayed"), 0);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// a record cut short by a crash is dropped
+	assert_int_equal(system("printf \"V 2 'time' 'enabled\" >> " CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal"), 0);
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_journal_replayed");
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_journal_expected " CONFIG_DIRECTORY_PATH_TMP "test_config_journal_replayed"), 0);
+	assert_int_not_equal(system("grep -q enabled " CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal"), 0);
+
+	// committing writes the base file and empties the journal
+	error = uci2_journal_commit(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct");
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_journal_expected " CONFIG_DIRECTORY_PATH_TMP "test_config_correct"), 0);
+	assert_int_not_equal(system("test -s " CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal"), 0);
+
+	error = uci2_journal_close(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	uci2_ast_destroy(&uci2_ast);
+
+	// a journal that can not be written is reported by the commit of a transaction and by closing it
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_open(uci2_ast, "/dev/full");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "@system[0]", "host", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "router");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_txn_commit(uci2_ast);
+	assert_int_equal(error, UE_FILE_IO);
+
+	// the change is kept in the AST and later commits keep reporting the lost record
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "router");
+
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_txn_commit(uci2_ast);
+	assert_int_equal(error, UE_FILE_IO);
+
+	error = uci2_journal_close(uci2_ast);
+	assert_int_equal(error, UE_FILE_IO);
+	error = uci2_journal_close(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	// a change made outside of a transaction is reported when the journal is closed
+	error = uci2_journal_open(uci2_ast, "/dev/full");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "gateway");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_close(uci2_ast);
+	assert_int_equal(error, UE_FILE_IO);
+
+	uci2_ast_destroy(&uci2_ast);
+
+	// a journal that does not apply is refused
+	assert_int_equal(system("echo \"R 1 'missing'\" > " CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal"), 0);
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_correct.journal");
+	assert_int_equal(error, UE_PARSER);
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_ast_clone(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_ast_t *clone = NULL;
+	uci2_ast_t *clone_nested = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *node = NULL;
+	const char *value = NULL;
+	size_t count = 0;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_clone(uci2_ast, NULL);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	// removed nodes are not copied
+	error = uci2_node_get(uci2_ast, "@system[0]", "timezone", &node);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(node);
+
+	error = uci2_ast_clone(uci2_ast, &clone);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_clone_source");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_ast_sync(clone, CONFIG_DIRECTORY_PATH_TMP "test_config_clone");
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_clone_source " CONFIG_DIRECTORY_PATH_TMP "test_config_clone"), 0);
+
+	// the clone is changed on its own, with its own indexes
+	error = uci2_node_get(clone, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_add(clone, root_node, "zone", "lan", &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_add(clone, section_node, "input", "ACCEPT", &node);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(clone, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "router");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "lan", NULL, &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+	error = uci2_node_get(uci2_ast, "@system[0]", "hostname", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_not_equal(value, "router");
+
+	error = uci2_search(clone, "router", search_count, &count);
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(count, 1);
+
+	// names and children copied in bulk are changed and undone like any other
+	error = uci2_txn_begin(clone);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(clone, "ntp", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(section_node, "ntp_clone");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_add(clone, section_node, "interval", "60", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_txn_rollback(clone);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(clone, "ntp", "interval", &node);
+	assert_int_equal(error, UE_NODE_NOT_FOUND);
+
+	error = uci2_txn_begin(clone);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(section_node, "ntp_clone");
+	assert_int_equal(error, UE_NONE);
+	error = uci2_txn_commit(clone);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(clone, "ntp_clone", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_section_name_set(section_node, "ntp");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_clone(clone, &clone_nested);
+	assert_int_equal(error, UE_NONE);
+	uci2_ast_destroy(&clone);
+
+	error = uci2_node_get(clone_nested, "lan", "input", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_get(node, &value);
+	assert_int_equal(error, UE_NONE);
+	assert_string_equal(value, "ACCEPT");
+
+	uci2_ast_destroy(&clone_nested);
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_node_move(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *root_node = NULL;
+	uci2_node_t *rules[4] = {0};
+	uci2_node_t *section_node = NULL;
+	uci2_node_t *list_node = NULL;
+	uci2_node_t *elements[3] = {0};
+	uci2_node_t *node = NULL;
+	uci2_node_iterator_t *node_iterator = NULL;
+	char name[16] = {0};
+	char order[128] = {0};
+
+	error = uci2_ast_create(&uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(uci2_ast, NULL, NULL, &root_node);
+	assert_int_equal(error, UE_NONE);
+
+	for (size_t i = 0; i < 4; i++) {
+		snprintf(name, sizeof(name), "rule%zu", i);
+		error = uci2_node_section_add(uci2_ast, root_node, "rule", name, &rules[i]);
+		assert_int_equal(error, UE_NONE);
+	}
+
+	error = uci2_node_option_add(uci2_ast, rules[0], "src", "lan", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_add(uci2_ast, rules[0], "dest", "wan", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_add(uci2_ast, rules[0], "proto", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, list_node, "tcp", &elements[0]);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, list_node, "udp", &elements[1]);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_list_element_add(uci2_ast, list_node, "icmp", &elements[2]);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_move_after(rules[0], rules[2]);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_move_before(rules[3], rules[1]);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_move_before(rules[3], rules[3]);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_type(uci2_ast, "rule", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "rule3 rule1 rule2 rule0");
+
+	error = uci2_node_get(uci2_ast, "@rule[3]", NULL, &node);
+	assert_int_equal(error, UE_NONE);
+	assert_ptr_equal(node, rules[0]);
+
+	// options and lists move within their section, elements within their list
+	error = uci2_node_set_position(list_node, 0);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(uci2_ast, "rule0", "src", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(node, 2);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(node, 3);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_move_before(elements[2], elements[0]);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_move_after(elements[0], elements[1]);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_move_before(node, rules[1]);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+	error = uci2_node_move_before(elements[0], node);
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+
+	error = uci2_node_iterator_new(rules[0], &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "proto dest src");
+
+	error = uci2_node_iterator_new(list_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "icmp udp tcp");
+
+	// a rolled back move puts the node back
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(rules[0], 0);
+	assert_int_equal(error, UE_NONE);
+	uci2_node_remove(rules[1]);
+	error = uci2_node_move_after(rules[3], rules[2]);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_type(uci2_ast, "rule", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "rule3 rule1 rule2 rule0");
+
+	// the order is written out, and replayed from the journal
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_move");
+	assert_int_equal(error, UE_NONE);
+	uci2_ast_destroy(&uci2_ast);
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_move", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_move.journal");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_get(uci2_ast, "rule0", "proto", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_new(list_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "icmp udp tcp");
+
+	error = uci2_node_get(uci2_ast, "rule0", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(section_node, 0);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(uci2_ast, "rule0", "proto", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(list_node, 2);
+	assert_int_equal(error, UE_NONE);
+	uci2_ast_destroy(&uci2_ast);
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_move", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_journal_open(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_move.journal");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_node_iterator_new_by_type(uci2_ast, "rule", &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "rule0 rule3 rule1 rule2");
+
+	error = uci2_node_get(uci2_ast, "rule0", NULL, &section_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_new(section_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "dest src proto");
+
+	// moves and a removal undone together come back in the order they were in
+	error = uci2_txn_begin(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_get(uci2_ast, "rule0", "src", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(node, 0);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_new(section_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "src dest proto");
+
+	uci2_node_remove(node);
+	error = uci2_node_get(uci2_ast, "rule0", "proto", &list_node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_set_position(list_node, 0);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_new(section_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "proto dest");
+
+	error = uci2_txn_rollback(uci2_ast);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_iterator_new(section_node, &node_iterator);
+	assert_int_equal(error, UE_NONE);
+	order_get(node_iterator, order, sizeof(order));
+	assert_string_equal(order, "dest src proto");
+
+	uci2_ast_destroy(&uci2_ast);
+}
+
+static void test_uci2_ast_sync_error(void **state)
+{
+	uci2_error_e error = 0;
+	uci2_ast_t *uci2_ast = NULL;
+	uci2_node_t *node = NULL;
+
+	error = uci2_config_parse(CONFIG_DIRECTORY_PATH_TMP "test_config_correct", &uci2_ast);
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_sync");
+	assert_int_equal(error, UE_NONE);
+	assert_int_equal(system("cp " CONFIG_DIRECTORY_PATH_TMP "test_config_sync " CONFIG_DIRECTORY_PATH_TMP "test_config_sync_before"), 0);
+
+	// a value that can not be written fails the sync and leaves the file as it was
+	error = uci2_node_get(uci2_ast, "ntp", "enabled", &node);
+	assert_int_equal(error, UE_NONE);
+	error = uci2_node_option_value_set(node, "line\nbreak");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_sync");
+	assert_int_equal(error, UE_INVALID_ARGUMENT);
+	assert_int_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_sync " CONFIG_DIRECTORY_PATH_TMP "test_config_sync_before"), 0);
+	assert_int_not_equal(system("test -e " CONFIG_DIRECTORY_PATH_TMP "test_config_sync.tmp"), 0);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "missing/test_config_sync");
+	assert_int_equal(error, UE_FILE_IO);
+
+	error = uci2_node_option_value_set(node, "0");
+	assert_int_equal(error, UE_NONE);
+
+	error = uci2_ast_sync(uci2_ast, CONFIG_DIRECTORY_PATH_TMP "test_config_sync");
+	assert_int_equal(error, UE_NONE);
+	assert_int_not_equal(system("cmp -s " CONFIG_DIRECTORY_PATH_TMP "test_config_sync " CONFIG_DIRECTORY_PATH_TMP "test_config_sync_before"), 0);
+	assert_int_not_equal(system("test -e " CONFIG_DIRECTORY_PATH_TMP "test_config_sync.tmp"), 0);
+
+	uci2_ast_destroy(&uci2_ast);
+}